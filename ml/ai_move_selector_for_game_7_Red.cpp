@@ -0,0 +1,124 @@
+/*
+    Red7 AI Move Selector
+
+    Описание(ru):
+    Этот файл реализует проверку ИИ-соперника на основе обученной модели (game_7_Red_inference.h).
+    Игрок 1 выбирает ход с максимальной оценкой модели среди ходов getWinningMoves,
+    игрок 2 ходит случайно, как в data_generator_for_game_7_Red.cpp.
+    В конце выводится доля побед модели и среднее время выбора хода в микросекундах.
+
+    Использование:
+    - ./ai_move_selector <weights.bin> [numGames]
+    - Для AVX2/FMA ядер собирать с -O2 -mavx2 -mfma (без них используется скалярная реализация).
+*/
+
+/*
+    Red7 AI Move Selector
+
+    Description(eng):
+    This file implements a check of the AI opponent based on a trained model (game_7_Red_inference.h).
+    Player 1 chooses the move with the highest model score among the moves from getWinningMoves,
+    while player 2 moves randomly, as in data_generator_for_game_7_Red.cpp.
+    At the end, the model's win rate and the average move selection time in microseconds are printed.
+
+    Usage:
+    - ./ai_move_selector <weights.bin> [numGames]
+    - Build with -O2 -mavx2 -mfma to use the AVX2/FMA kernels (the scalar implementation is used otherwise).
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "game_7_Red_inference.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Использование: " << argv[0] << " <weights.bin> [numGames]\n";
+        return 1;
+    }
+
+    MlpModel model;
+    try {
+        model = MlpModel::loadFromFile(argv[1]);
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+
+    int numGames = argc > 2 ? stoi(argv[2]) : 1000;
+    const int numPlayers = 2;
+    const int aiPlayer = 0;
+    mt19937 rng(random_device{}());
+
+    int aiWins = 0;
+    long long decisions = 0;
+    chrono::nanoseconds decisionTime(0);
+
+    for (int game = 0; game < numGames; ++game) {
+        vector<Card> deck = createFullDeck();
+        shuffle(deck.begin(), deck.end(), rng);
+
+        vector<vector<Card>> hands(numPlayers);
+        for (int player = 0; player < numPlayers; ++player) {
+            hands[player].assign(deck.begin() + player * 7, deck.begin() + (player + 1) * 7);
+        }
+        vector<vector<Card>> palettes(numPlayers);
+        Card ruleCard = Card(Red, 0);
+        vector<bool> active(numPlayers, true);
+
+        while (count(active.begin(), active.end(), true) > 1) {
+            for (int i = 0; i < numPlayers; ++i) {
+                if (!active[i]) continue;
+
+                vector<vector<Card>> otherPalettes;
+                uint64_t otherPalettesMask = 0, othersOccupiedMask = 0;
+                for (int j = 0; j < numPlayers; ++j) {
+                    if (j != i && active[j]) {
+                        otherPalettes.push_back(palettes[j]);
+                        otherPalettesMask |= cardsToMask(palettes[j]);
+                        othersOccupiedMask |= cardsToMask(palettes[j]) | cardsToMask(hands[j]);
+                    }
+                }
+
+                auto start = chrono::steady_clock::now();
+                auto moves = getWinningMoves(ruleCard, hands[i], palettes[i], otherPalettes);
+                if (moves.empty()) {
+                    active[i] = false;
+                    break;
+                }
+
+                int choice;
+                if (i == aiPlayer) {
+                    choice = chooseBestMove(model, moves, otherPalettesMask, othersOccupiedMask);
+                    decisionTime += chrono::steady_clock::now() - start;
+                    ++decisions;
+                } else {
+                    uniform_int_distribution<int> dist(0, (int)moves.size() - 1);
+                    choice = dist(rng);
+                }
+
+                auto& [newRuleCard, newHand, newPalette] = moves[choice];
+                ruleCard = newRuleCard;
+                hands[i] = newHand;
+                palettes[i] = newPalette;
+            }
+        }
+
+        if (active[aiPlayer]) {
+            ++aiWins;
+        }
+    }
+
+    cout << "Побед модели: " << aiWins << " из " << numGames
+         << " (" << (numGames ? 100.0 * aiWins / numGames : 0.0) << "%)\n";
+    if (decisions > 0) {
+        cout << "Среднее время выбора хода (getWinningMoves + модель): "
+             << chrono::duration<double, micro>(decisionTime).count() / decisions << " мкс\n";
+    }
+    return 0;
+}
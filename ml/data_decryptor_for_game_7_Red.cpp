@@ -25,6 +25,8 @@
         [7]  deckBinary         — 50 бит, оставшиеся в колоде карты
         [8]  eliminatedFlag     — 0 = игрок активен, 1 = выбыл
         [9]  winFlag            — 0 = проиграл, 1 = победил
+    Строки с 12 полями (режим генератора --per-opponent-palettes) вместо поля [6] содержат
+    три палитры соперников в порядке хода, а остальные поля сдвинуты на 2.
 
     Описание битовых полей:
     - Каждая маска — строка из 50 символов ('0' или '1').
@@ -65,6 +67,8 @@
     [7] deckBinary         — 50 bits, remaining cards in deck
     [8] eliminatedFlag     — 0 = active player, 1 = eliminated
     [9] winFlag            — 0 = lost, 1 = won
+    Lines with 12 fields (the generator's --per-opponent-palettes mode) hold the three opponent
+    palettes in turn order instead of field [6], and the remaining fields are shifted by 2.
 
     Description of bit fields:
     - Each bitmask is a 50-character string ('0' or '1').
@@ -117,10 +121,12 @@ void decodeLine(const std::string& line) {
         fields.push_back(token);
     }
 
-    if (fields.size() != 10) {
+    // 12 полей — формат --per-opponent-palettes: по полю на каждого соперника вместо объединённого
+    if (fields.size() != 10 && fields.size() != 12) {
         std::cerr << "Invalid input line format: " << line << std::endl;
         return;
     }
+    int opponentFields = (int)fields.size() - 9;
 
     int gameNumber = std::stoi(fields[0]);
     int roundNumber = std::stoi(fields[1]);
@@ -128,15 +134,13 @@ void decodeLine(const std::string& line) {
     std::string ruleCardBinary = fields[3];
     std::string handBinary = fields[4];
     std::string paletteBinary = fields[5];
-    std::string otherPaletteBinary = fields[6];
-    std::string deckBinary = fields[7];
-    bool eliminated = fields[8] == "1";
-    bool won = fields[9] == "1";
+    std::string deckBinary = fields[6 + opponentFields];
+    bool eliminated = fields[7 + opponentFields] == "1";
+    bool won = fields[8 + opponentFields] == "1";
 
     std::vector<std::string> ruleCards = decodeBitmask(ruleCardBinary);
     std::vector<std::string> handCards = decodeBitmask(handBinary);
     std::vector<std::string> paletteCards = decodeBitmask(paletteBinary);
-    std::vector<std::string> otherPaletteCards = decodeBitmask(otherPaletteBinary);
     std::vector<std::string> deckCards = decodeBitmask(deckBinary);
 
     std::cout << "\nGame: " << gameNumber << ", Round: " << roundNumber
@@ -148,8 +152,11 @@ void decodeLine(const std::string& line) {
     for (const auto& card : handCards) std::cout << card << ", ";
     std::cout << "\nPalette: ";
     for (const auto& card : paletteCards) std::cout << card << ", ";
-    std::cout << "\nOther Palettes: ";
-    for (const auto& card : otherPaletteCards) std::cout << card << ", ";
+    for (int k = 0; k < opponentFields; ++k) {
+        if (opponentFields == 1) std::cout << "\nOther Palettes: ";
+        else std::cout << "\nOpponent " << (k + 1) << " Palette: ";
+        for (const auto& card : decodeBitmask(fields[6 + k])) std::cout << card << ", ";
+    }
     std::cout << "\nDeck: ";
     for (const auto& card : deckCards) std::cout << card << ", ";
     std::cout << "\nEliminated: " << (eliminated ? "Yes" : "No");
@@ -15,6 +15,10 @@
     - cardsToBinaryArray / ruleCardToBinary / otherPalettesToBinary / deckCardsToBinary:
         функции для кодирования состояния игры в бинарные строки.
     - playFullGame: симулирует полную игру, записывая состояния в файл dataset.txt.
+    - GameConfig / dealGame / simulateGame: параметры партии (2–4 игрока, размер руки, колода добора,
+        правило discard-to-draw, раздельные палитры соперников); симуляция и генерация ходов специализированы
+        шаблоном по числу игроков, палитры соперников передаются в getWinningMovesForMasks массивом масок.
+    - Правила и функции кодирования вынесены в game_7_Red_rules.h и используются также другими инструментами.
 
         Формат выходных данных (одна строка на ход активного игрока):
         [0]  gameNumber         — номер симулируемой игры (целое число начиная с 0)
@@ -28,6 +32,12 @@
         [7]  deckBinary         — 50 бит, оставшиеся в колоде карты (1 = есть в колоде, 0 = отсутствует)
         [8]  eliminatedFlag     — 1 бит (0 = игрок активен, 1 = выбыл)
         [9]  winFlag            — 1 бит (0 = игрок проиграл, 1 = игрок победил к концу игры)
+        С --per-opponent-palettes вместо поля [6] пишутся три поля — палитры соперников в порядке хода
+        после игрока (нули для отсутствующих и выбывших), строка содержит 12 полей.
+        Такие строки читает только data_decryptor_for_game_7_Red.cpp: упакованный формат
+        (game_7_Red_packed_dataset.h), export_mlp_weights.py и раскладка входа game_7_Red_inference.h
+        рассчитаны только на 10 полей.
+        С --draw-pile поле deckBinary содержит только карты колоды добора.
 
     Описание битовых полей:
     - Каждое поле длиной 50 бит соответствует полному множеству возможных карт Red7.
@@ -39,6 +49,25 @@
         Использование:
     - Запускается симуляция N игр (playFullGame), каждая игра записывает все состояния активного игрока.
     - Выход сохраняется в файл dataset.txt (каждая строка — один ход).
+    - Режим квот: --quotas quotas.txt [--oversample K] [--max-games N] [--seed S].
+      Каждая строка файла квот задаёт страту "rule,round,players,handSize,quota" (например "Violet,6+,4,*,1000").
+      Для каждой страты ведётся резервуарная выборка; симуляция останавливается, когда все квоты выполнены,
+      и в dataset.txt записываются только отобранные строки.
+      Страта считается выполненной после просмотра quota * K подходящих строк (K по умолчанию 10),
+      чтобы выборка была равномерной по многим играм, а не состояла из первых найденных строк.
+      Страты с числом игроков вне 2–4 или размером руки больше --hand-size отвергаются при загрузке;
+      для недостижимого номера раунда выводится предупреждение.
+    - Воспроизводимый режим: --seed S [--games N] — seed каждой партии выводится из S.
+    - Компактный режим: --replay games.r7rp [--games N] [--seed S] — вместо dataset.txt пишутся seed,
+      число игроков, размер руки и ходы каждой партии (game_7_Red_replay.h); строки восстанавливает replay_tool_for_game_7_Red.cpp.
+    - Параметры партии (во всех режимах): --players N (2–4, по умолчанию 2), --hand-size N (по умолчанию 7),
+      --draw-pile — оставшиеся после раздачи карты образуют колоду добора,
+      --discard-to-draw — продвинутое правило: сменив правило картой с номиналом больше числа карт
+      в своей палитре, игрок берёт карту из колоды (включает --draw-pile),
+      --per-opponent-palettes — отдельное поле палитры на каждого соперника.
+      В режиме квот число игроков задают страты. Режим --replay поддерживает только базовые правила.
+    - --score-cache scores.r7sc — таблица оценок палитр (game_7_Red_score_cache.h, строится
+      score_cache_generator_for_game_7_Red.cpp) вместо вызовов comparison_*; результат не меняется.
 
     Зависимости:
     - Стандартная библиотека C++ (iostream, vector, map, array, string, fstream, random, и др.)
@@ -60,6 +89,10 @@
     - cardsToBinaryArray, ruleCardToBinary, otherPalettesToBinary and deckCardsToBinary:
         Functions for encoding the game state into binary strings.
     - playFullGame: Simulates a full game by writing states to the dataset.txt file.
+    - The rules and encoding functions live in game_7_Red_rules.h and are shared with the other tools.
+    - GameConfig / dealGame / simulateGame: game settings (2–4 players, hand size, draw pile,
+        the discard-to-draw rule, separate opponent palettes); the simulation and move generation are specialised
+        by a template on the player count; opponent palettes reach getWinningMovesForMasks as an array of masks.
 
     The output data format is one line per turn of the active player.
     [0] GameNumber: the number of the simulated game (an integer starting from 0).
@@ -72,6 +105,12 @@
     [7] DeckBinary — 50 bits representing the remaining cards in the deck (1 = present, 0 = missing).
     [8] EliminatedFlag: 1 bit (0 = player is active; 1 = player has been eliminated).
     [9] WinFlag: 1 bit (0 = player lost; 1 = player won by the end of the game).
+    With --per-opponent-palettes, field [6] is replaced by three fields — the opponents' palettes in turn order
+    after the player (zeros for missing and eliminated opponents), so a line has 12 fields.
+    Only data_decryptor_for_game_7_Red.cpp reads such lines: the packed format
+    (game_7_Red_packed_dataset.h), export_mlp_weights.py and the game_7_Red_inference.h input layout
+    expect 10 fields only.
+    With --draw-pile, DeckBinary holds only the cards of the draw pile.
 
     Description of the bit fields:
     - Each 50-bit field corresponds to the full set of possible Red7 cards.
@@ -83,6 +122,25 @@
     Usage:
     A simulation of N games (playFullGame) runs, with each game recording all the states of the active player.
     The output is saved to a file called dataset.txt (each line represents one move).
+    Quota mode: --quotas quotas.txt [--oversample K] [--max-games N] [--seed S].
+    Each line of the quota file defines a stratum "rule,round,players,handSize,quota" (e.g. "Violet,6+,4,*,1000").
+    Reservoir sampling is kept per stratum; the simulation stops once all quotas are met,
+    and only the sampled lines are written to dataset.txt.
+    A stratum is met after quota * K matching lines have been seen (K is 10 by default),
+    so that the sample is spread uniformly over many games instead of being the first lines found.
+    Strata with a player count outside 2–4 or a hand size above --hand-size are rejected at load time;
+    an unreachable round number produces a warning.
+    Reproducible mode: --seed S [--games N] — the seed of every game is derived from S.
+    Compact mode: --replay games.r7rp [--games N] [--seed S] — instead of dataset.txt, the seed,
+    player count, hand size and moves of every game are written (game_7_Red_replay.h); replay_tool_for_game_7_Red.cpp restores the lines.
+    Game settings (in every mode): --players N (2–4, 2 by default), --hand-size N (7 by default),
+    --draw-pile — the cards left after the deal form a draw pile,
+    --discard-to-draw — advanced rule: a player who changes the rule with a card whose value exceeds the number
+    of cards in their palette draws a card from the pile (implies --draw-pile),
+    --per-opponent-palettes — a separate palette field for every opponent.
+    In quota mode the player count comes from the strata. The --replay mode supports only the basic rules.
+    --score-cache scores.r7sc — the palette score table (game_7_Red_score_cache.h, built by
+    score_cache_generator_for_game_7_Red.cpp) instead of calling comparison_*; the output does not change.
 
     Dependencies:
     Standard C++ library (iostream, vector, map, array, string, fstream, random, etc.).
@@ -102,545 +160,533 @@
 #include <array>
 #include <fstream>
 #include <sstream> 
+#include <climits>
+#include <cmath>
+#include <memory>
+
+#include "game_7_Red_rules.h"
+#include "game_7_Red_replay.h"
+#include "game_7_Red_score_cache.h"
 using namespace std;
 
-enum Color {
-    Red = 0,
-    Orange = 1,
-    Yellow = 2,
-    Green = 3,
-    LightBlue = 4,
-    Blue = 5,
-    Violet = 6
-};
+unsigned int getSeedFromTime() {
+    auto now = chrono::system_clock::now();
+    time_t now_time_t = chrono::system_clock::to_time_t(now);
+    tm local_tm = *localtime(&now_time_t);
 
-string getColorName(Color color) {
-    switch (color) {
-        case Red:    return "Red";
-        case Orange: return "Orange";
-        case Yellow: return "Yellow";
-        case Green:  return "Green";
-        case LightBlue: return "LightBlue";
-        case Blue: return "Blue";
-        case Violet: return "Violet";
-        default:     return "Unknown";
-    }
+    // Суммируем часы, минуты, секунды, день, месяц, год
+    unsigned int seed = local_tm.tm_hour + local_tm.tm_min + local_tm.tm_sec +
+                        local_tm.tm_mday + (local_tm.tm_mon + 1) + (local_tm.tm_year + 1900);
+    return seed;
 }
 
-class Card {
-public:
-    Card(Color c, int v) : color(c), value(v) {}
-    Card() : color(Red), value(0) {} 
-
-    int getValue() const { return value; }
-    Color getColor() const { return color; }
-
-    string toString() const {
-        return getColorName(color) + " " + to_string(value);
-    }
-
-    bool operator<(const Card& other) const {
-        if (value != other.value)
-            return value < other.value;
-        return color > other.color;
-    }
-
-private:
-    Color color;
-    int value;
+// Параметры партии. Конфигурация по умолчанию совпадает с исходной генерацией:
+// 2 игрока по 7 карт, без колоды добора, палитры соперников объединены в одно поле.
+struct GameConfig {
+    int numPlayers = 2;
+    int handSize = 7;
+    bool drawPile = false;            // карты, оставшиеся после раздачи, образуют колоду добора
+    bool discardToDraw = false;       // продвинутое правило: сменив правило картой с номиналом больше
+                                      // числа карт в своей палитре, игрок берёт карту из колоды
+    bool perOpponentPalettes = false; // отдельное поле палитры на каждого соперника вместо объединённого
 };
 
-Card findMaxCard(const vector<Card>& cards) {
-    if (cards.empty()) {
-        throw runtime_error("Пустой вектор карт");
-    }
+const int kMaxPlayers = 4;
 
-    Card maxCard = cards[0];
-    for (const Card& c : cards) {
-        if (maxCard < c) {
-            maxCard = c;
-        }
-    }
-    return maxCard;
-}
-
-bool comparison_red(const vector<Card>& hand1, const vector<Card>& hand2) {
-    if (hand1.empty() || hand2.empty()) {
-        return false;
-    }
-    return findMaxCard(hand1) < findMaxCard(hand2);
+string validateConfig(const GameConfig& config) {
+    if (config.numPlayers < 2 || config.numPlayers > kMaxPlayers) return "Поддерживается от 2 до 4 игроков";
+    if (config.handSize < 1 || config.handSize > 8) return "Размер руки должен быть от 1 до 8";
+    if (config.numPlayers * config.handSize > 49) return "Не хватает карт для раздачи";
+    if (config.discardToDraw && !config.drawPile) return "Правило discard-to-draw требует колоду добора";
+    return "";
 }
 
-tuple<int, Card> comparison_orange(const vector<Card>& cards) {
-    if (cards.empty()) {
-        throw runtime_error("Пустой вектор карт");
-    }
-
-    map<int, vector<Card>> groups;
-    for (const Card& c : cards) {
-        groups[c.getValue()].push_back(c);
-    }
-
-    int maxCount = 0;
-    Card maxCard = cards[0];
-
-    for (const auto& [value, group] : groups) {
-        int count = (int)group.size();
-        Card localMax = findMaxCard(group);
-
-        if (count > maxCount || (count == maxCount && maxCard < localMax)) {
-            maxCount = count;
-            maxCard = localMax;
-        }
-    }
+struct Deal {
+    vector<vector<Card>> hands;
+    vector<Card> drawPile;  // верх колоды — последний элемент
+};
 
-    return make_tuple(maxCount, maxCard);
+// Раздача общая с форматом партий (dealHands из game_7_Red_replay.h): по seed партии её можно повторить
+Deal dealGame(const GameConfig& config, mt19937& gen) {
+    Deal deal;
+    deal.hands = dealHands(config.numPlayers, config.handSize, gen, config.drawPile ? &deal.drawPile : nullptr);
+    return deal;
 }
 
-tuple<int, Card> comparison_yellow(const vector<Card>& cards) {
-    if (cards.empty()) {
-        throw runtime_error("Пустой вектор карт");
-    }
+// Симуляция для фиксированного числа игроков N: состояние хранится в массивах фиксированного размера,
+// циклы по игрокам имеют известную на этапе компиляции границу и разворачиваются компилятором.
+// Маски рук и палитр обновляются после каждого хода: из них кодируются строки, а генератор ходов
+// getWinningMovesForMasks получает палитры соперников как std::array<uint64_t, N - 1> без копирования карт.
+template <int N>
+vector<GameRow> simulateGameFor(int gameNumber, const GameConfig& config, const Deal& deal, mt19937& rng, vector<uint8_t>* moveLog) {
+    array<vector<Card>, N> hands;
+    array<vector<Card>, N> palettes;
+    array<uint64_t, N> handMasks{};
+    array<uint64_t, N> paletteMasks{};
+    array<bool, N> active;
+    for (int p = 0; p < N; ++p) {
+        hands[p] = deal.hands[p];
+        handMasks[p] = cardsToMask(hands[p]);
+        active[p] = true;
+    }
+    vector<Card> drawPile = deal.drawPile;
+    uint64_t drawPileMask = cardsToMask(drawPile);
 
-    map<Color, vector<Card>> groups;
-    for (const Card& c : cards) {
-        groups[c.getColor()].push_back(c);
-    }
+    Card ruleCard = Card(Red, 0); // красная 0 - начальное правило
+    int finalWinner = -1;
+    int round = 1;
 
-    int maxCount = 0;
-    Card maxCard = cards[0];
+    vector<GameRow> rows;
 
-    for (const auto& [color, group] : groups) {
-        int count = (int)group.size();
-        Card localMax = findMaxCard(group);
+    auto recordState = [&](int i, bool eliminated) {
+        uint64_t occupied = 0, others = 0;
+        for (int j = 0; j < N; ++j) {
+            if (!active[j]) continue;
+            occupied |= handMasks[j] | paletteMasks[j];
+            if (j != i) others |= paletteMasks[j];
+        }
+        // без колоды добора "колода" — все карты вне рук и палитр активных игроков, как в deckCardsToBinary
+        uint64_t deckMask = config.drawPile ? drawPileMask : kDeckMask & ~occupied;
 
-        if (count > maxCount || (count == maxCount && maxCard < localMax)) {
-            maxCount = count;
-            maxCard = localMax;
+        string line;
+        line.reserve(24 + 51 * (4 + kMaxPlayers));
+        line += to_string(gameNumber) + "," + to_string(round) + "," + to_string(i + 1);
+        line += "," + maskToBinary(1ULL << getCardIndex(ruleCard));
+        line += "," + maskToBinary(handMasks[i]);
+        line += "," + maskToBinary(paletteMasks[i]);
+        if (config.perOpponentPalettes) {
+            // соперники в порядке хода после игрока i; отсутствующие и выбывшие — нулевые поля
+            for (int k = 1; k < kMaxPlayers; ++k) {
+                int j = (i + k) % N;
+                line += "," + maskToBinary(k < N && active[j] ? paletteMasks[j] : 0);
+            }
+        } else {
+            line += "," + maskToBinary(others);
         }
-    }
+        line += "," + maskToBinary(deckMask);
+        line += eliminated ? ",1" : ",0";
+        rows.push_back({std::move(line), i, round, ruleCard.getColor(), (int)hands[i].size()});
+    };
 
-    return make_tuple(maxCount, maxCard);
-}
+    while (true) {
+        int activeCount = count(active.begin(), active.end(), true);
 
-tuple<int, Card> comparison_green(const vector<Card>& cards) {
-    vector<Card> filtered;
-    for (const Card& c : cards) {
-        if (c.getValue() % 2 == 0) {
-            filtered.push_back(c);
+        if (activeCount == 1) {
+            finalWinner = (int)(find(active.begin(), active.end(), true) - active.begin());
+            finishGameRows(rows, finalWinner);
+            return rows;
         }
-    }
-    if (filtered.empty()) {
-        throw runtime_error("Нет чётных карт");
-    }
-
-    return make_tuple((int)filtered.size(), findMaxCard(filtered));
-}
 
-tuple<int, Card> comparison_lightblue(const vector<Card>& cards) {
-    set<Color> uniqueColors;
-    for (const Card& c : cards) {
-        uniqueColors.insert(c.getColor());
-    }
-    return make_tuple((int)uniqueColors.size(), findMaxCard(cards));
-}
+        for (int i = 0; i < N; ++i) {
+            if (!active[i]) continue;
 
-tuple<int, Card> comparison_blue(const vector<Card>& cards) {
-    if (cards.empty()) {
-        throw runtime_error("Пустой вектор карт");
-    }
+            // палитры соперников передаются масками; у выбывших — 0, как пропущенная пустая палитра
+            array<uint64_t, N - 1> otherPaletteMasks;
+            for (int k = 1; k < N; ++k) {
+                int j = (i + k) % N;
+                otherPaletteMasks[k - 1] = active[j] ? paletteMasks[j] : 0;
+            }
 
-    vector<int> values;
-    for (const Card& c : cards) {
-        values.push_back(c.getValue());
-    }
+            auto moves = getWinningMovesForMasks(ruleCard, hands[i], palettes[i], otherPaletteMasks);
 
-    sort(values.begin(), values.end());
+            if (moves.empty()) {
+                if (moveLog) moveLog->push_back(kReplayEliminated);
 
-    int maxLen = 1, curLen = 1;
-    int maxEndValue = values[0];
+                int stillActive = count(active.begin(), active.end(), true);
+                if (stillActive == 1) {
+                    // последний игрок не может сделать ход — но он побеждает
+                    finalWinner = i;
+                    recordState(i, false);
+                    finishGameRows(rows, finalWinner);
+                    return rows;
+                }
 
-    for (size_t i = 1; i < values.size(); ++i) {
-        if (values[i] == values[i - 1] + 1) {
-            ++curLen;
-            if (curLen > maxLen) {
-                maxLen = curLen;
-                maxEndValue = values[i];
+                // обычный случай: игрок выбывает
+                active[i] = false;
+                recordState(i, true);
+                continue;
             }
-        } else if (values[i] != values[i - 1]) {
-            curLen = 1;
-        }
-    }
 
-    Card maxCard = cards[0];
-    bool found = false;
+            // обычный случай: игрок делает ход
+            uniform_int_distribution<int> dist(0, (int)moves.size() - 1);
+            auto& move = moves[dist(rng)];
+            auto& [newRuleCard, newHand, newPalette] = move;
+            if (moveLog) moveLog->push_back(encodeReplayMove(hands[i], palettes[i], ruleCard, move));
+
+            bool ruleChanged = getCardIndex(newRuleCard) != getCardIndex(ruleCard);
+            ruleCard = newRuleCard;
+            hands[i] = newHand;
+            palettes[i] = newPalette;
 
-    for (const Card& c : cards) {
-        if (c.getValue() == maxEndValue) {
-            if (!found || maxCard < c) {
-                maxCard = c;
-                found = true;
+            if (config.discardToDraw && ruleChanged && ruleCard.getValue() > (int)palettes[i].size() && !drawPile.empty()) {
+                hands[i].push_back(drawPile.back());
+                drawPileMask &= ~(1ULL << getCardIndex(drawPile.back()));
+                drawPile.pop_back();
             }
-        }
-    }
+            handMasks[i] = cardsToMask(hands[i]);
+            paletteMasks[i] = cardsToMask(palettes[i]);
 
-    return make_tuple(maxLen, maxCard);
-}
-
-tuple<int, Card> comparison_violet(const vector<Card>& cards) {
-    vector<Card> filtered;
-    for (const Card& c : cards) {
-        if (c.getValue() < 4) {
-            filtered.push_back(c);
+            recordState(i, false);
         }
-    }
 
-    if (filtered.empty()) {
-        throw runtime_error("Нет карт с номиналом меньше 4");
+        ++round;
     }
-
-    return make_tuple((int)filtered.size(), findMaxCard(filtered));
 }
 
-vector<tuple<Card, vector<Card>, vector<Card>>> getWinningMoves(
-    Card ruleCard,
-    const vector<Card>& hand,
-    const vector<Card>& myPalette,
-    const vector<vector<Card>>& otherPalettes
-) {
-    vector<tuple<Card, vector<Card>, vector<Card>>> results;
-
-    Color currentRule = ruleCard.getColor();
-
-    auto checkWin = [&](const vector<Card>& me, Color ruleColor) {
-        try {
-            tuple<int, Card> myResult;
-
-            if (ruleColor == Red)            myResult = make_tuple(1, findMaxCard(me));
-            else if (ruleColor == Orange)    myResult = comparison_orange(me);
-            else if (ruleColor == Yellow)    myResult = comparison_yellow(me);
-            else if (ruleColor == Green)     myResult = comparison_green(me);
-            else if (ruleColor == LightBlue) myResult = comparison_lightblue(me);
-            else if (ruleColor == Blue)      myResult = comparison_blue(me);
-            else if (ruleColor == Violet)    myResult = comparison_violet(me);
-
-            for (const auto& opp : otherPalettes) {
-                if (opp.empty()) continue;
-
-                tuple<int, Card> oppResult;
-
-                if (ruleColor == Red)            oppResult = make_tuple(1, findMaxCard(opp));
-                else if (ruleColor == Orange)    oppResult = comparison_orange(opp);
-                else if (ruleColor == Yellow)    oppResult = comparison_yellow(opp);
-                else if (ruleColor == Green)     oppResult = comparison_green(opp);
-                else if (ruleColor == LightBlue) oppResult = comparison_lightblue(opp);
-                else if (ruleColor == Blue)      oppResult = comparison_blue(opp);
-                else if (ruleColor == Violet)    oppResult = comparison_violet(opp);
-
-                if (myResult < oppResult) return false;
-            }
-
-            return true;
-        } catch (...) {
-            return false;
-        }
-    };
-
-    // 1. Одинарный ход — в палитру
-    for (size_t i = 0; i < hand.size(); ++i) {
-        vector<Card> newPalette = myPalette;
-        newPalette.push_back(hand[i]);
-
-        if (checkWin(newPalette, currentRule)) {
-            vector<Card> newHand = hand;
-            newHand.erase(newHand.begin() + i);
-            results.push_back(make_tuple(ruleCard, newHand, newPalette));
-        }
+// Симулирует одну игру со случайными ходами и возвращает все состояния активных игроков.
+// Если передан moveLog, в него записываются байты ходов для формата партий (game_7_Red_replay.h).
+vector<GameRow> simulateGame(int gameNumber, const GameConfig& config, const Deal& deal, mt19937& rng, vector<uint8_t>* moveLog = nullptr) {
+    switch (config.numPlayers) {
+        case 2: return simulateGameFor<2>(gameNumber, config, deal, rng, moveLog);
+        case 3: return simulateGameFor<3>(gameNumber, config, deal, rng, moveLog);
+        case 4: return simulateGameFor<4>(gameNumber, config, deal, rng, moveLog);
+        default: throw runtime_error("Поддерживается от 2 до 4 игроков");
     }
+}
 
-    // 2. Одинарный ход — смена правила
-    for (size_t i = 0; i < hand.size(); ++i) {
-        Color newRule = hand[i].getColor();
-        Card newRuleCard = hand[i];
-        vector<Card> newHand = hand;
-        newHand.erase(newHand.begin() + i);
-
-        if (checkWin(myPalette, newRule)) {
-            results.push_back(make_tuple(newRuleCard, newHand, myPalette));
-        }
+void playFullGame(int gameNumber, const GameConfig& config) {
+    ofstream out("dataset.txt", ios::app);
+    if (!out.is_open()) {
+        cerr << "Не удалось открыть файл dataset.txt для записи\n";
+        return;
     }
 
-    // 3. Двойной ход — и в палитру, и смена правила
-    for (size_t i = 0; i < hand.size(); ++i) {
-        for (size_t j = 0; j < hand.size(); ++j) {
-            if (i == j) continue;
-
-            vector<Card> newPalette = myPalette;
-            newPalette.push_back(hand[i]);
-            Color newRule = hand[j].getColor();
-            Card newRuleCard = hand[j];
-
-            vector<Card> newHand = hand;
-            if (i > j) {
-                newHand.erase(newHand.begin() + i);
-                newHand.erase(newHand.begin() + j);
-            } else {
-                newHand.erase(newHand.begin() + j);
-                newHand.erase(newHand.begin() + i);
-            }
+    mt19937 gen(getSeedFromTime());
+    Deal deal = dealGame(config, gen);
+    mt19937 rng(getSeedFromTime());
 
-            if (checkWin(newPalette, newRule)) {
-                results.push_back(make_tuple(newRuleCard, newHand, newPalette));
-            }
-        }
+    for (const auto& row : simulateGame(gameNumber, config, deal, rng)) {
+        out << row.line;
     }
-
-    return results;
 }
 
-vector<Card> createFullDeck() {
-    vector<Card> deck;
-    for (int color = 0; color <= 6; ++color) {
-        for (int value = 1; value <= 7; ++value) {
-            deck.emplace_back(static_cast<Color>(color), value);
-        }
-    }
-    return deck;
-}
+// Диапазон значений страты: "*", "N", "A-B" или "A+"
+struct StratumRange {
+    int min = 0;
+    int max = INT_MAX;
 
-unsigned int getSeedFromTime() {
-    auto now = chrono::system_clock::now();
-    time_t now_time_t = chrono::system_clock::to_time_t(now);
-    tm local_tm = *localtime(&now_time_t);
+    bool contains(int value) const { return value >= min && value <= max; }
+};
 
-    // Суммируем часы, минуты, секунды, день, месяц, год
-    unsigned int seed = local_tm.tm_hour + local_tm.tm_min + local_tm.tm_sec +
-                        local_tm.tm_mday + (local_tm.tm_mon + 1) + (local_tm.tm_year + 1900);
-    return seed;
+// Неотрицательное целое без знака и лишних символов
+bool parseStratumNumber(const string& text, int& value) {
+    if (text.empty() || text.size() > 9 || !all_of(text.begin(), text.end(), ::isdigit)) return false;
+    value = stoi(text);
+    return true;
 }
 
-vector<vector<Card>> dealCards(int numPlayers) {
-    vector<Card> deck = createFullDeck();
-    unsigned int seed = getSeedFromTime();
-
-    mt19937 gen(seed);
-    shuffle(deck.begin(), deck.end(), gen);
-
-    vector<vector<Card>> hands(numPlayers);
-
-    int cardsPerPlayer = 7;
-
-    for (int player = 0; player < numPlayers; ++player) {
-        hands[player].assign(deck.begin() + player * cardsPerPlayer, deck.begin() + (player + 1) * cardsPerPlayer);
+bool parseStratumRange(const string& text, StratumRange& range) {
+    range = StratumRange();
+    if (text == "*") return true;
+    if (!text.empty() && text.back() == '+') {
+        return parseStratumNumber(text.substr(0, text.size() - 1), range.min);
     }
-
-    return hands;
-}
-int getCardIndex(const Card& card) {
-    if (card.getColor() == Red && card.getValue() == 0) {
-        return 49;
-    } else {
-        return static_cast<int>(card.getColor()) * 7 + card.getValue() - 1;
+    size_t dash = text.find('-');
+    if (dash == string::npos) {
+        if (!parseStratumNumber(text, range.min)) return false;
+        range.max = range.min;
+        return true;
     }
+    return parseStratumNumber(text.substr(0, dash), range.min) &&
+           parseStratumNumber(text.substr(dash + 1), range.max) && range.min <= range.max;
 }
 
-// Бинарный вектор из 50 битов: 49 обычных карт + красная 0
-string cardsToBinaryArray(const vector<Card>& cards) {
-    array<int, 50> presence = {0};
-    for (const auto& c : cards) {
-        presence[getCardIndex(c)] = 1;
-    }
-    string result;
-    for (int i = 0; i < 50; ++i) {
-        result += presence[i] ? '1' : '0';
-    }
-    return result;
-}
+// Квота страты с резервуаром: после просмотра seen строк в reservoir лежит равномерная выборка из них
+struct StratumQuota {
+    string spec;
+    int rule = -1;    // -1 — любой цвет
+    StratumRange round, players, handSize;
+    size_t target = 0;
 
-string ruleCardToBinary(const Card& ruleCard) {
-    array<int, 50> presence = {0};
-    presence[getCardIndex(ruleCard)] = 1;
-    string result;
-    for (int i = 0; i < 50; ++i) {
-        result += presence[i] ? '1' : '0';
+    vector<string> reservoir;
+    long long seen = 0;
+
+    bool matches(const GameRow& row, int numPlayers) const {
+        return (rule < 0 || rule == row.rule) && round.contains(row.round) &&
+               players.contains(numPlayers) && handSize.contains(row.handSize);
     }
-    return result;
-}
 
-string otherPalettesToBinary(const vector<vector<Card>>& palettes, int currentPlayer, const vector<bool>& active) {
-    array<int, 50> presence = {0};
-    for (int i = 0; i < (int)palettes.size(); ++i) {
-        if (i != currentPlayer && active[i]) {
-            for (const auto& c : palettes[i]) {
-                presence[getCardIndex(c)] = 1;
-            }
+    void offer(const string& line, mt19937& rng) {
+        ++seen;
+        if (reservoir.size() < target) {
+            reservoir.push_back(line);
+            return;
+        }
+        uniform_int_distribution<long long> dist(0, seen - 1);
+        long long j = dist(rng);
+        if (j < (long long)target) {
+            reservoir[j] = line;
         }
     }
-    string result;
-    for (int i = 0; i < 50; ++i) {
-        result += presence[i] ? '1' : '0';
-    }
-    return result;
+};
+
+// Пересекается ли диапазон страты с отрезком [min, max]
+bool rangeIntersects(const StratumRange& range, int min, int max) {
+    return range.min <= max && range.max >= min;
 }
 
-string deckCardsToBinary(const vector<vector<Card>>& hands, const vector<vector<Card>>& palettes, const vector<bool>& active) {
-    array<int, 50> presence = {0};
+// Наибольший возможный номер раунда: без добора игрок теряет карту каждый раунд и выбывает
+// в раунде handSize + 1; каждая карта из колоды добора может продлить партию ещё на раунд.
+int maxPossibleRound(const GameConfig& config, int minPlayers) {
+    int drawnCards = config.discardToDraw ? 49 - minPlayers * config.handSize : 0;
+    return config.handSize + 1 + drawnCards;
+}
 
-    // Изначально все обычные карты в колоде (0–48), красная 0 (49) не входит
-    for (int i = 0; i < 49; ++i) {
-        presence[i] = 1;
-    }
+// Файл квот: по строке на страту "rule,round,players,handSize,quota", например "Violet,6+,4,*,1000".
+// Строка датасета относится к первой подходящей страте; '#' начинает комментарий.
+// Страты, которым не может соответствовать ни одна строка при параметрах config, отвергаются:
+// число игроков вне 2–4 или размер руки вне 0..config.handSize (рука после хода может быть пустой).
+vector<StratumQuota> loadQuotas(const string& path, const GameConfig& config) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        throw runtime_error("Не удалось открыть файл квот " + path);
+    }
+
+    vector<StratumQuota> quotas;
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        line.erase(remove_if(line.begin(), line.end(), ::isspace), line.end());
+        if (line.empty()) continue;
+
+        vector<string> fields;
+        stringstream ss(line);
+        string token;
+        while (getline(ss, token, ',')) {
+            fields.push_back(token);
+        }
+        string where = " в строке " + to_string(lineNumber) + " файла квот: " + line;
+        if (fields.size() != 5 || line.back() == ',') {
+            throw runtime_error("Ожидается 5 полей \"rule,round,players,handSize,quota\"" + where);
+        }
 
-    for (int i = 0; i < (int)hands.size(); ++i) {
-        if (active[i]) {
-            for (const auto& c : hands[i]) {
-                presence[getCardIndex(c)] = 0;
-            }
-            for (const auto& c : palettes[i]) {
-                presence[getCardIndex(c)] = 0;
+        StratumQuota quota;
+        quota.spec = line;
+        if (fields[0] != "*") {
+            quota.rule = colorFromName(fields[0]);
+            if (quota.rule < 0) throw runtime_error("Неизвестный цвет правила \"" + fields[0] + "\"" + where);
+        }
+        const char* names[] = {"round", "players", "handSize"};
+        StratumRange* ranges[] = {&quota.round, &quota.players, &quota.handSize};
+        for (int f = 0; f < 3; ++f) {
+            if (!parseStratumRange(fields[1 + f], *ranges[f])) {
+                throw runtime_error(string("Неверный диапазон ") + names[f] + " \"" + fields[1 + f] + "\"" + where);
             }
         }
+        if (!rangeIntersects(quota.players, 2, kMaxPlayers)) {
+            throw runtime_error("Число игроков \"" + fields[2] + "\" вне 2–4" + where);
+        }
+        if (!rangeIntersects(quota.handSize, 0, config.handSize)) {
+            throw runtime_error("Размер руки \"" + fields[3] + "\" больше раздаваемого (" +
+                                to_string(config.handSize) + ")" + where);
+        }
+        int maxRound = maxPossibleRound(config, max(2, quota.players.min));
+        if (quota.round.min > maxRound) {
+            cerr << "Предупреждение: раунд \"" << fields[1] << "\" недостижим (последний возможный раунд — "
+                 << maxRound << ")" << where << "\n";
+        }
+        int target = 0;
+        if (!parseStratumNumber(fields[4], target)) {
+            throw runtime_error("Неверная квота \"" + fields[4] + "\"" + where);
+        }
+        quota.target = target;
+        quotas.push_back(quota);
     }
-
-    string result;
-    for (int i = 0; i < 50; ++i) {
-        result += presence[i] ? '1' : '0';
-    }
-    return result;
+    return quotas;
 }
 
-void playFullGame(int gameNumber, int numPlayers) {
-    ofstream out("dataset.txt", ios::app);
-    if (!out.is_open()) {
-        cerr << "Не удалось открыть файл dataset.txt для записи\n";
-        return;
-    }
+// Генерация по квотам: симулирует игры, пока каждая страта не увидит target * oversample строк
+// (или пока не закончится maxGames), и записывает в dataset.txt только содержимое резервуаров.
+// При oversample = 1 резервуар совпал бы с первыми target подходящими строками, сгруппированными
+// в первых играх; по умолчанию просматривается в 10 раз больше строк, чем попадает в выборку.
+// Число игроков задают страты, остальные параметры партии берутся из config.
+int runStratifiedGeneration(vector<StratumQuota>& quotas, const GameConfig& config, double oversample, long long maxGames, unsigned int seed) {
+    mt19937 rng(seed);
 
-    auto hands = dealCards(numPlayers);
-    vector<vector<Card>> palettes(numPlayers);
-    Card ruleCard = Card(Red, 0); // красная 0 - начальное правило
-    vector<bool> active(numPlayers, true);
-    int finalWinner = -1;
-    int round = 1;
-    mt19937 rng(getSeedFromTime());
-
-    struct MoveInfo {
-        string line;
-        int playerIndex;
+    auto quotaMet = [&](const StratumQuota& quota) {
+        return quota.seen >= (long long)ceil(quota.target * oversample);
     };
-    vector<MoveInfo> allMoves;
-
-    while (true) {
-        int activeCount = count(active.begin(), active.end(), true);
 
-        if (activeCount == 1) {
-            for (int i = 0; i < numPlayers; ++i) {
-                if (active[i]) {
-                    finalWinner = i;
+    long long game = 0;
+    for (; game < maxGames; ++game) {
+        // число игроков выбирается по кругу среди тех, для которых ещё есть незаполненные страты
+        vector<int> playerCounts;
+        for (int numPlayers = 2; numPlayers <= 4; ++numPlayers) {
+            for (const auto& quota : quotas) {
+                if (!quotaMet(quota) && quota.players.contains(numPlayers)) {
+                    playerCounts.push_back(numPlayers);
                     break;
                 }
             }
-
-            for (auto& move : allMoves) {
-                if (move.playerIndex == finalWinner)
-                    move.line += ",1\n";  // победил
-                else
-                    move.line += ",0\n";  // не победил
-                out << move.line;
-            }
-
-            return;
         }
-
-        for (int i = 0; i < numPlayers; ++i) {
-            if (!active[i]) continue;
-
-            vector<vector<Card>> otherPalettes;
-            for (int j = 0; j < numPlayers; ++j) {
-                if (j != i && active[j]) {
-                    otherPalettes.push_back(palettes[j]);
+        if (playerCounts.empty()) break;
+
+        int numPlayers = playerCounts[game % playerCounts.size()];
+        GameConfig gameConfig = config;
+        gameConfig.numPlayers = numPlayers;
+        Deal deal = dealGame(gameConfig, rng);
+        auto rows = simulateGame((int)game, gameConfig, deal, rng);
+        for (const auto& row : rows) {
+            for (auto& quota : quotas) {
+                if (quota.matches(row, numPlayers)) {
+                    quota.offer(row.line, rng);
+                    break;
                 }
             }
+        }
 
-            auto moves = getWinningMoves(ruleCard, hands[i], palettes[i], otherPalettes);
-
-            stringstream ss;
-            ss << gameNumber << "," << round << "," << (i + 1) << ",";
-
-            if (moves.empty()) {
-    int stillActive = count(active.begin(), active.end(), true);
-    if (stillActive == 1) {
-        // последний игрок не может сделать ход — но он побеждает
-        finalWinner = i;
-        ss << ruleCardToBinary(ruleCard) << ",";
-        ss << cardsToBinaryArray(hands[i]) << ",";
-        ss << cardsToBinaryArray(palettes[i]) << ",";
-        ss << otherPalettesToBinary(palettes, i, active) << ",";
-        ss << deckCardsToBinary(hands, palettes, active);
-        ss << ",0"; // не выбыл
-        allMoves.push_back({ss.str(), i});
-
-        for (auto& move : allMoves) {
-            if (move.playerIndex == finalWinner)
-                move.line += ",1\n";  // победил
-            else
-                move.line += ",0\n";  // не победил
-            out << move.line;
+        if (game % 1000 == 0) {
+            cout << "Симуляция игры " << (game + 1) << "\n";
         }
+    }
 
-        return;
+    ofstream out("dataset.txt");
+    if (!out.is_open()) {
+        cerr << "Не удалось открыть dataset.txt для записи\n";
+        return 1;
     }
 
-    // обычный случай: игрок выбывает
-    active[i] = false;
-    ss << ruleCardToBinary(ruleCard) << ",";
-    ss << cardsToBinaryArray(hands[i]) << ",";
-    ss << cardsToBinaryArray(palettes[i]) << ",";
-    ss << otherPalettesToBinary(palettes, i, active) << ",";
-    ss << deckCardsToBinary(hands, palettes, active);
-    ss << ",1"; // выбыл
-    allMoves.push_back({ss.str(), i});
-    continue;
+    cout << "Сыграно игр: " << game << "\n";
+    for (const auto& quota : quotas) {
+        for (const auto& line : quota.reservoir) {
+            out << line;
+        }
+        cout << quota.spec << ": записано " << quota.reservoir.size() << " из " << quota.target
+             << " (просмотрено " << quota.seen << ")" << (quotaMet(quota) ? "" : " — квота не выполнена") << "\n";
+    }
+    return 0;
 }
 
-            // обычный случай: игрок делает ход
-            uniform_int_distribution<int> dist(0, (int)moves.size() - 1);
-            auto& [newRuleCard, newHand, newPalette] = moves[dist(rng)];
+// Генерация с воспроизводимыми партиями: seed каждой партии берётся из общего генератора,
+// раздача и ходы партии зависят только от него. Если задан replayPath, вместо dataset.txt
+// пишется компактный файл партий (game_7_Red_replay.h), из которого строки восстанавливаются по требованию.
+int runSeededGeneration(int numGames, const GameConfig& config, unsigned int seed, const string& replayPath) {
+    mt19937 master(seed);
+
+    if (!replayPath.empty()) {
+        // формат партий хранит только раздачу и ходы базовых правил с объединённым полем палитр соперников
+        if (config.drawPile || config.perOpponentPalettes) {
+            cerr << "Режим --replay не поддерживает колоду добора и раздельные палитры\n";
+            return 1;
+        }
+        ReplayWriter writer(replayPath);
+        long long moves = 0;
+        for (int i = 0; i < numGames; ++i) {
+            ReplayGame game;
+            game.gameNumber = i;
+            game.seed = master();
+            game.numPlayers = config.numPlayers;
+            game.handSize = config.handSize;
+            mt19937 rng(game.seed);
+            Deal deal = dealGame(config, rng);
+            simulateGame(i, config, deal, rng, &game.moves);
+            moves += game.moves.size();
+            writer.append(game);
+        }
+        writer.close();
+        cout << "Записано партий: " << numGames << ", ходов: " << moves << ", байт: " << writer.bytes() << "\n";
+        return 0;
+    }
 
-            ruleCard = newRuleCard;
-            hands[i] = newHand;
-            palettes[i] = newPalette;
+    ofstream out("dataset.txt");
+    if (!out.is_open()) {
+        cerr << "Не удалось открыть dataset.txt для записи\n";
+        return 1;
+    }
+    for (int i = 0; i < numGames; ++i) {
+        mt19937 rng(master());
+        Deal deal = dealGame(config, rng);
+        for (const auto& row : simulateGame(i, config, deal, rng)) {
+            out << row.line;
+        }
+    }
+    return 0;
+}
 
-            ss << ruleCardToBinary(ruleCard) << ",";
-            ss << cardsToBinaryArray(hands[i]) << ",";
-            ss << cardsToBinaryArray(palettes[i]) << ",";
-            ss << otherPalettesToBinary(palettes, i, active) << ",";
-            ss << deckCardsToBinary(hands, palettes, active);
-            ss << ",0"; // не выбыл
-            allMoves.push_back({ss.str(), i});
+int main(int argc, char* argv[]) {
+    string quotasPath, replayPath, scoreCachePath;
+    double oversample = 10.0;
+    long long maxGames = 10000000;
+    int numGames = 10000;
+    unsigned int seed = random_device{}();
+    bool seeded = false;
+    GameConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        // флаги без значения
+        if (arg == "--draw-pile") {
+            config.drawPile = true;
+            continue;
+        }
+        if (arg == "--discard-to-draw") {
+            config.drawPile = config.discardToDraw = true;
+            continue;
+        }
+        if (arg == "--per-opponent-palettes") {
+            config.perOpponentPalettes = true;
             continue;
         }
 
-        ++round;
+        if (i + 1 >= argc) {
+            cerr << "Не задано значение для " << arg << "\n";
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--quotas") quotasPath = value;
+        else if (arg == "--oversample") oversample = max(1.0, stod(value));
+        else if (arg == "--max-games") maxGames = stoll(value);
+        else if (arg == "--games") numGames = stoi(value);
+        else if (arg == "--replay") replayPath = value;
+        else if (arg == "--score-cache") scoreCachePath = value;
+        else if (arg == "--players") config.numPlayers = stoi(value);
+        else if (arg == "--hand-size") config.handSize = stoi(value);
+        else if (arg == "--seed") {
+            seed = stoul(value);
+            seeded = true;
+        } else {
+            cerr << "Неизвестный аргумент " << arg << "\n";
+            return 1;
+        }
     }
-}
 
+    string configError = validateConfig(config);
+    if (!configError.empty()) {
+        cerr << configError << "\n";
+        return 1;
+    }
 
+    unique_ptr<RuleScoreCache> scoreCache;
+    try {
+        if (!scoreCachePath.empty()) {
+            scoreCache = make_unique<RuleScoreCache>(scoreCachePath);
+            scoreCache->install();
+        }
+        if (!quotasPath.empty()) {
+            auto quotas = loadQuotas(quotasPath, config);
+            return runStratifiedGeneration(quotas, config, oversample, maxGames, seed);
+        }
+        if (!replayPath.empty() || seeded) {
+            return runSeededGeneration(numGames, config, seed, replayPath);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
 
-int main() {
     std::ofstream out("dataset.txt");
     if (!out.is_open()) {
         std::cerr << "Не удалось открыть dataset.txt для записи\n";
         return 1;
     }
     out.close();
-    int numGames = 10000;
-    int numPlayers = 2;
     for (int i = 0; i < numGames; ++i) {
         if (i % 1000 == 0) {
             cout << "Симуляция игры " << (i + 1) << " из " << numGames << endl;
         }
-        playFullGame(i, numPlayers);
+        playFullGame(i, config);
     }
     return 0;
 }
@@ -0,0 +1,400 @@
+/*
+    Red7 Dataset Query Tool
+
+    Описание(ru):
+    Этот файл реализует инструмент запросов к датасету Red7 без полного разбора текста.
+    Сначала dataset.txt упаковывается в бинарный формат (game_7_Red_packed_dataset.h),
+    затем фильтры из командной строки компилируются в побитовые предикаты над 64-битными масками
+    и сравнения над словом meta. Сканирование идёт по столбцам блоками в нескольких потоках,
+    с ядрами AVX2 (по 4 строки за инструкцию) и скалярной реализацией при сборке без -mavx2.
+    Читаются только те столбцы, на которые есть фильтры; слова битовой карты, где уже не осталось
+    подходящих строк, пропускаются при проверке следующих столбцов.
+
+    Команды:
+    - pack <dataset.txt> <dataset.r7pk>        — упаковать текстовый датасет.
+    - query <dataset.r7pk> [фильтры] [опции]   — вывести подходящие строки (в формате dataset.txt) или их число.
+
+    Фильтры (FIELD = rule | hand | palette | other | deck, CARD = "Blue 5", COLOR = Red ... Violet):
+    - --rule COLOR                 — правило указанного цвета (можно повторять: любой из цветов).
+    - --FIELD-has CARD             — карта присутствует в поле.
+    - --FIELD-lacks CARD           — карты нет в поле.
+    - --FIELD-has-color COLOR      — в поле есть хотя бы одна карта цвета (повторы объединяются через ИЛИ).
+    - --round N, --round-min N, --round-max N, --game-min N, --game-max N
+    - --player N, --eliminated 0|1, --won 0|1
+
+    Опции:
+    - --count        — вывести только число подходящих строк.
+    - --limit N      — вывести не более N строк.
+    - --threads N    — число потоков (по умолчанию — число ядер).
+
+    Пример: ./dataset_query query dataset.r7pk --rule Blue --hand-has "Red 7" --count
+*/
+
+/*
+    Red7 Dataset Query Tool
+
+    Description(eng):
+    This file implements a query tool over the Red7 dataset that avoids full text parsing.
+    First, dataset.txt is packed into a binary format (game_7_Red_packed_dataset.h).
+    Then the command-line filters are compiled into bitwise predicates on 64-bit masks
+    and comparisons on the meta word. The scan goes column by column over blocks on several threads,
+    with AVX2 kernels (4 rows per instruction) and a scalar implementation when built without -mavx2.
+    Only the columns that have filters are read, and bitmap words with no remaining matching rows
+    are skipped when the following columns are checked.
+
+    Commands:
+    - pack <dataset.txt> <dataset.r7pk>        — pack a text dataset.
+    - query <dataset.r7pk> [filters] [options] — print the matching rows (in dataset.txt format) or their count.
+
+    Filters (FIELD = rule | hand | palette | other | deck, CARD = "Blue 5", COLOR = Red ... Violet):
+    - --rule COLOR                 — the rule has the given colour (repeatable: any of the colours).
+    - --FIELD-has CARD             — the card is present in the field.
+    - --FIELD-lacks CARD           — the card is absent from the field.
+    - --FIELD-has-color COLOR      — the field holds at least one card of the colour (repeats are OR-ed).
+    - --round N, --round-min N, --round-max N, --game-min N, --game-max N
+    - --player N, --eliminated 0|1, --won 0|1
+
+    Options:
+    - --count        — print only the number of matching rows.
+    - --limit N      — print at most N rows.
+    - --threads N    — number of threads (defaults to the number of cores).
+
+    Example: ./dataset_query query dataset.r7pk --rule Blue --hand-has "Red 7" --count
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "game_7_Red_packed_dataset.h"
+using namespace std;
+
+// Все карты цвета, включая красную 0 для Red
+uint64_t colorMask(int color) {
+    uint64_t mask = 0x7FULL << (color * 7);
+    if (color == Red) mask |= 1ULL << 49;
+    return mask;
+}
+
+// (x & all) == all, (x & none) == 0, any == 0 || (x & any) != 0
+struct MaskFilter {
+    uint64_t all = 0;
+    uint64_t none = 0;
+    uint64_t any = 0;
+
+    bool active() const { return all || none || any; }
+};
+
+struct Query {
+    MaskFilter masks[5];
+    uint64_t metaMask = 0;
+    uint64_t metaValue = 0;
+    uint64_t roundMin = 0, roundMax = 0xFFFF;
+    uint64_t gameMin = 0, gameMax = UINT32_MAX;
+
+    bool metaActive() const {
+        return metaMask || roundMin > 0 || roundMax < 0xFFFF || gameMin > 0 || gameMax < UINT32_MAX;
+    }
+
+    bool unsatisfiable() const {
+        for (const auto& m : masks) {
+            if (m.all & m.none) return true;
+        }
+        return roundMin > roundMax || gameMin > gameMax;
+    }
+};
+
+struct MaskPredicate {
+    MaskFilter filter;
+
+    bool scalar(uint64_t x) const {
+        return (x & (filter.all | filter.none)) == filter.all && (!filter.any || (x & filter.any));
+    }
+
+#if defined(__AVX2__)
+    __m256i vector(__m256i x) const {
+        const __m256i required = _mm256_set1_epi64x(filter.all | filter.none);
+        const __m256i all = _mm256_set1_epi64x(filter.all);
+        __m256i ok = _mm256_cmpeq_epi64(_mm256_and_si256(x, required), all);
+        if (filter.any) {
+            __m256i hit = _mm256_cmpeq_epi64(_mm256_and_si256(x, _mm256_set1_epi64x(filter.any)), _mm256_setzero_si256());
+            ok = _mm256_andnot_si256(hit, ok);
+        }
+        return ok;
+    }
+#endif
+};
+
+struct MetaPredicate {
+    const Query& query;
+
+    bool scalar(uint64_t meta) const {
+        uint64_t round = metaRound(meta), game = metaGame(meta);
+        return (meta & query.metaMask) == query.metaValue &&
+               round >= query.roundMin && round <= query.roundMax &&
+               game >= query.gameMin && game <= query.gameMax;
+    }
+
+#if defined(__AVX2__)
+    // Все сравниваемые величины меньше 2^32, поэтому знаковое сравнение 64-битных слов корректно
+    __m256i vector(__m256i meta) const {
+        __m256i ok = _mm256_cmpeq_epi64(_mm256_and_si256(meta, _mm256_set1_epi64x(query.metaMask)),
+                                        _mm256_set1_epi64x(query.metaValue));
+        __m256i round = _mm256_and_si256(meta, _mm256_set1_epi64x(0xFFFF));
+        __m256i game = _mm256_srli_epi64(meta, 32);
+        __m256i bad = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi64(_mm256_set1_epi64x(query.roundMin), round),
+                            _mm256_cmpgt_epi64(round, _mm256_set1_epi64x(query.roundMax))),
+            _mm256_or_si256(_mm256_cmpgt_epi64(_mm256_set1_epi64x(query.gameMin), game),
+                            _mm256_cmpgt_epi64(game, _mm256_set1_epi64x(query.gameMax))));
+        return _mm256_andnot_si256(bad, ok);
+    }
+#endif
+};
+
+// Проверяет столбец и пересекает результат с битовой картой (бит r = строка r блока).
+// first == true — карта ещё пуста и заполняется целиком.
+template <typename Predicate>
+void scanColumn(const uint64_t* column, uint32_t rows, const Predicate& predicate, uint64_t* bitmap, bool first) {
+    uint32_t words = (rows + 63) / 64;
+    for (uint32_t w = 0; w < words; ++w) {
+        if (!first && bitmap[w] == 0) continue;
+
+        const uint64_t* x = column + (size_t)w * 64;
+        uint64_t bits = 0;
+#if defined(__AVX2__)
+        for (int k = 0; k < 16; ++k) {
+            __m256i ok = predicate.vector(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + 4 * k)));
+            bits |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(ok)) << (4 * k);
+        }
+#else
+        for (int k = 0; k < 64; ++k) {
+            bits |= (uint64_t)predicate.scalar(x[k]) << k;
+        }
+#endif
+        bitmap[w] = first ? bits : bitmap[w] & bits;
+    }
+}
+
+// Число подходящих строк блока; bitmap — rows/64 слов (округление вверх)
+uint64_t scanBlock(const PackedDatasetReader& reader, uint64_t block, const Query& query, uint64_t* bitmap) {
+    uint32_t rows = reader.rowsInBlock(block);
+    uint32_t words = (rows + 63) / 64;
+    bool first = true;
+
+    for (int f = 0; f < 5; ++f) {
+        if (!query.masks[f].active()) continue;
+        scanColumn(reader.column(block, f), rows, MaskPredicate{query.masks[f]}, bitmap, first);
+        first = false;
+    }
+    if (query.metaActive()) {
+        scanColumn(reader.column(block, ColumnMeta), rows, MetaPredicate{query}, bitmap, first);
+        first = false;
+    }
+    if (first) {
+        fill(bitmap, bitmap + words, ~0ULL);
+    }
+    if (rows % 64) {
+        bitmap[words - 1] &= (1ULL << (rows % 64)) - 1;  // хвост последнего блока дополнен нулями
+    }
+
+    uint64_t matches = 0;
+    for (uint32_t w = 0; w < words; ++w) {
+        matches += __builtin_popcountll(bitmap[w]);
+    }
+    return matches;
+}
+
+int packDataset(const string& inputPath, const string& outputPath) {
+    ifstream in(inputPath);
+    if (!in.is_open()) {
+        cerr << "Не удалось открыть " << inputPath << "\n";
+        return 1;
+    }
+
+    PackedDatasetWriter writer(outputPath);
+    string line;
+    uint64_t lineNumber = 0, skipped = 0;
+    PackedRow row;
+    while (getline(in, line)) {
+        ++lineNumber;
+        if (line.empty()) continue;
+        if (line.back() == '\r') line.pop_back();
+        if (!parseDatasetLine(line, row)) {
+            if (skipped++ < 10) cerr << "Неверная строка " << lineNumber << "\n";
+            continue;
+        }
+        writer.append(row);
+    }
+    writer.close();
+
+    cout << "Упаковано строк: " << writer.rows() << ", пропущено: " << skipped << "\n";
+    return 0;
+}
+
+int fieldFromName(const string& name) {
+    const char* names[5] = {"rule", "hand", "palette", "other", "deck"};
+    for (int f = 0; f < 5; ++f) {
+        if (name == names[f]) return f;
+    }
+    return -1;
+}
+
+int parseColorArg(const string& text) {
+    int color = colorFromName(text);
+    if (color < 0) throw runtime_error("Неизвестный цвет: " + text);
+    return color;
+}
+
+int runQuery(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Не указан файл упакованного датасета\n";
+        return 1;
+    }
+
+    Query query;
+    bool countOnly = false;
+    uint64_t limit = UINT64_MAX;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+
+    for (int i = 3; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--count") {
+            countOnly = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Нет значения для " << arg << "\n";
+            return 1;
+        }
+        string value = argv[++i];
+
+        if (arg == "--limit") limit = stoull(value);
+        else if (arg == "--threads") threads = max(1, stoi(value));
+        else if (arg == "--rule") query.masks[ColumnRule].any |= colorMask(parseColorArg(value));
+        else if (arg == "--round") query.roundMin = query.roundMax = stoul(value);
+        else if (arg == "--round-min") query.roundMin = stoul(value);
+        else if (arg == "--round-max") query.roundMax = stoul(value);
+        else if (arg == "--game-min") query.gameMin = stoul(value);
+        else if (arg == "--game-max") query.gameMax = stoul(value);
+        else if (arg == "--player") {
+            query.metaMask |= 0xFFULL << 16;
+            query.metaValue = (query.metaValue & ~(0xFFULL << 16)) | (stoull(value) & 0xFF) << 16;
+        } else if (arg == "--eliminated" || arg == "--won") {
+            uint64_t bit = arg == "--won" ? kMetaWonBit : kMetaEliminatedBit;
+            query.metaMask |= bit;
+            query.metaValue = value == "1" ? query.metaValue | bit : query.metaValue & ~bit;
+        } else if (arg.rfind("--", 0) == 0) {
+            // --FIELD-has / --FIELD-lacks / --FIELD-has-color
+            string spec = arg.substr(2);
+            size_t dash = spec.find('-');
+            int field = dash == string::npos ? -1 : fieldFromName(spec.substr(0, dash));
+            string op = dash == string::npos ? "" : spec.substr(dash + 1);
+            if (field < 0) {
+                cerr << "Неизвестный фильтр " << arg << "\n";
+                return 1;
+            }
+
+            if (op == "has") query.masks[field].all |= 1ULL << getCardIndex(cardFromString(value));
+            else if (op == "lacks") query.masks[field].none |= 1ULL << getCardIndex(cardFromString(value));
+            else if (op == "has-color") query.masks[field].any |= colorMask(parseColorArg(value));
+            else {
+                cerr << "Неизвестный фильтр " << arg << "\n";
+                return 1;
+            }
+        } else {
+            cerr << "Неизвестный аргумент " << arg << "\n";
+            return 1;
+        }
+    }
+
+    PackedDatasetReader reader(argv[2]);
+    const uint64_t blocks = reader.blockCount();
+    const uint32_t bitmapWords = (reader.blockRows() + 63) / 64;
+
+    if (query.unsatisfiable()) {
+        if (countOnly) cout << 0 << "\n";
+        return 0;
+    }
+
+    // Для вывода строк храним битовые карты всех блоков; для подсчёта хватает одной на поток
+    vector<uint64_t> counts(blocks, 0);
+    vector<uint64_t> bitmaps(countOnly ? 0 : blocks * bitmapWords);
+    atomic<uint64_t> nextBlock(0);
+
+    auto start = chrono::steady_clock::now();
+    auto worker = [&]() {
+        vector<uint64_t> local(bitmapWords);
+        for (uint64_t b = nextBlock++; b < blocks; b = nextBlock++) {
+            uint64_t* bitmap = countOnly ? local.data() : &bitmaps[b * bitmapWords];
+            counts[b] = scanBlock(reader, b, query, bitmap);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < min<uint64_t>(threads, blocks); ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0;
+    for (uint64_t c : counts) total += c;
+
+    if (countOnly) {
+        cout << total << "\n";
+    } else {
+        string out;
+        uint64_t printed = 0;
+        for (uint64_t b = 0; b < blocks && printed < limit; ++b) {
+            if (counts[b] == 0) continue;
+            const uint64_t* bitmap = &bitmaps[b * bitmapWords];
+            for (uint32_t w = 0; w < bitmapWords && printed < limit; ++w) {
+                uint64_t bits = bitmap[w];
+                while (bits && printed < limit) {
+                    uint32_t index = w * 64 + __builtin_ctzll(bits);
+                    out += formatDatasetLine(reader.row(b, index));
+                    out += '\n';
+                    ++printed;
+                    bits &= bits - 1;
+                }
+                if (out.size() > (1 << 20)) {
+                    cout << out;
+                    out.clear();
+                }
+            }
+        }
+        cout << out;
+    }
+
+    cerr << "Просмотрено строк: " << reader.rowCount() << ", найдено: " << total
+         << ", время сканирования: " << seconds * 1000 << " мс\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    string command = argc > 1 ? argv[1] : "";
+    try {
+        if (command == "pack" && argc == 4) {
+            return packDataset(argv[2], argv[3]);
+        }
+        if (command == "query") {
+            return runQuery(argc, argv);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+
+    cerr << "Использование:\n"
+         << "  " << argv[0] << " pack <dataset.txt> <dataset.r7pk>\n"
+         << "  " << argv[0] << " query <dataset.r7pk> [фильтры] [--count] [--limit N] [--threads N]\n";
+    return 1;
+}
@@ -0,0 +1,73 @@
+import struct
+import sys
+
+import numpy as np
+import pandas as pd
+from sklearn.neural_network import MLPClassifier
+
+# Формат файла описан в game_7_Red_inference.h
+ACTIVATIONS = {"identity": 0, "relu": 1, "logistic": 2}
+
+columns = [
+    "gameNumber",
+    "roundNumber",
+    "playerNumber",
+    "ruleCardBinary",
+    "handBinary",
+    "paletteBinary",
+    "otherPalettesBinary",
+    "deckBinary",
+    "eliminatedFlag",
+    "winFlag"
+]
+
+bit_columns = columns[3:8]
+
+# Поддерживается только 10-полевой формат dataset.txt (палитры соперников объединены в одно поле),
+# как и вход game_7_Red_inference.h; строки генератора с --per-opponent-palettes содержат 12 полей.
+
+
+def export_mlp(layers, path):
+    """layers: список (weights[inputs][outputs], bias[outputs], activation)."""
+    with open(path, "wb") as f:
+        f.write(b"R7NN")
+        f.write(struct.pack("<II", 1, len(layers)))
+        for weights, bias, activation in layers:
+            weights = np.asarray(weights, dtype="<f4")
+            bias = np.asarray(bias, dtype="<f4")
+            f.write(struct.pack("<III", weights.shape[0], weights.shape[1], ACTIVATIONS[activation]))
+            f.write(weights.tobytes(order="C"))
+            f.write(bias.tobytes())
+
+
+def export_sklearn_mlp(clf, path):
+    # coefs_ в sklearn уже имеют форму [inputs][outputs]
+    layers = []
+    for i, (weights, bias) in enumerate(zip(clf.coefs_, clf.intercepts_)):
+        last = i == len(clf.coefs_) - 1
+        layers.append((weights, bias, clf.out_activation_ if last else clf.activation))
+    export_mlp(layers, path)
+
+
+def load_features(path, max_rows=None):
+    with open(path) as f:
+        first = f.readline()
+    if first.count(",") != len(columns) - 1:
+        raise ValueError(f"{path}: ожидается {len(columns)} полей в строке (формат без --per-opponent-palettes)")
+    df = pd.read_csv(path, header=None, names=columns, dtype=str, nrows=max_rows)
+    bits = df[bit_columns].agg("".join, axis=1)
+    X = np.frombuffer("".join(bits).encode(), dtype=np.uint8).reshape(len(df), -1) - ord("0")
+    y = df["winFlag"].astype(int).to_numpy()
+    return X.astype(np.float32), y
+
+
+if __name__ == "__main__":
+    dataset = sys.argv[1] if len(sys.argv) > 1 else "dataset.txt"
+    output = sys.argv[2] if len(sys.argv) > 2 else "weights.bin"
+
+    X, y = load_features(dataset, max_rows=200000)
+    clf = MLPClassifier(hidden_layer_sizes=(64, 32), max_iter=20)
+    clf.fit(X, y)
+    print("train accuracy:", clf.score(X, y))
+
+    export_sklearn_mlp(clf, output)
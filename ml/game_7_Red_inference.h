@@ -0,0 +1,329 @@
+/*
+    Red7 Move Scoring Inference Engine
+
+    Описание(ru):
+    Небольшой движок инференса для многослойного перцептрона (MLP), обученного на данных
+    из data_generator_for_game_7_Red.cpp. Позволяет ИИ-сопернику выбирать ход за микросекунды
+    без подключения полноценной ML-библиотеки.
+
+    Основные компоненты:
+    - StateMasks: состояние в той же раскладке из 250 бит, что и строка датасета
+        (правило, рука, палитра, палитры других игроков, колода — по 50 бит).
+        Это 10-полевой формат с объединёнными палитрами соперников; строки --per-opponent-palettes не подходят.
+    - encodeCandidateMove: кодирует ход из getWinningMoves в StateMasks (состояние после хода).
+    - MlpModel::loadFromFile: загрузка весов из бинарного файла (см. export_mlp_weights.py).
+    - MlpModel::predict: оценка пакета состояний. Первый слой считается разреженно —
+        для каждого установленного бита прибавляется одна строка весов (вход one-hot).
+        Остальные слои — плотные ядра AVX2/FMA (по 4 состояния за проход), со скалярной
+        реализацией, если компилятор собирает без -mavx2 -mfma.
+    - chooseBestMove: индекс хода с максимальной вероятностью победы.
+
+    Формат файла весов (little-endian):
+        char[4]  magic = "R7NN"
+        uint32   version = 1
+        uint32   numLayers
+        для каждого слоя:
+            uint32   inputs, outputs, activation (0 = линейная, 1 = ReLU, 2 = сигмоида)
+            float32  weights[inputs][outputs]
+            float32  bias[outputs]
+    Вход первого слоя — 250, выход последнего — 1 (вероятность победы активного игрока).
+*/
+
+/*
+    Red7 Move Scoring Inference Engine
+
+    Description(eng):
+    A small inference engine for a multilayer perceptron (MLP) trained on the data
+    produced by data_generator_for_game_7_Red.cpp. It lets the AI opponent choose a move
+    in microseconds without pulling in a full ML runtime.
+
+    Main components:
+    - StateMasks: a state in the same 250-bit layout as a dataset line
+        (rule, hand, palette, other palettes, deck — 50 bits each).
+        This is the 10-field format with merged opponent palettes; --per-opponent-palettes lines do not fit.
+    - encodeCandidateMove: encodes a move from getWinningMoves as StateMasks (the state after the move).
+    - MlpModel::loadFromFile: loads weights from a binary file (see export_mlp_weights.py).
+    - MlpModel::predict: evaluates a batch of states. The first layer is computed sparsely:
+        one weight row is added per set bit, since the input is one-hot.
+        The remaining layers use AVX2/FMA dense kernels (4 states per pass), with a scalar
+        implementation when the compiler is not building with -mavx2 -mfma.
+    - chooseBestMove: the index of the move with the highest win probability.
+
+    Weights file format (little-endian):
+        char[4]  magic = "R7NN"
+        uint32   version = 1
+        uint32   numLayers
+        for each layer:
+            uint32   inputs, outputs, activation (0 = linear, 1 = ReLU, 2 = sigmoid)
+            float32  weights[inputs][outputs]
+            float32  bias[outputs]
+    The first layer takes 250 inputs and the last layer has 1 output (the active player's win probability).
+*/
+
+#ifndef GAME_7_RED_INFERENCE_H
+#define GAME_7_RED_INFERENCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define RED7_NN_AVX2 1
+#endif
+
+#include "game_7_Red_rules.h"
+
+const int kStateFields = 5;
+const int kStateBits = kStateFields * 50;
+
+struct StateMasks {
+    uint64_t rule;
+    uint64_t hand;
+    uint64_t palette;
+    uint64_t otherPalettes;
+    uint64_t deck;
+};
+
+// otherPalettesMask — объединённые палитры активных соперников (как otherPalettesToBinary),
+// othersOccupiedMask — их руки и палитры вместе (нужно, чтобы колода совпала с deckCardsToBinary)
+inline StateMasks encodeCandidateMove(
+    const std::tuple<Card, std::vector<Card>, std::vector<Card>>& move,
+    uint64_t otherPalettesMask,
+    uint64_t othersOccupiedMask
+) {
+    const auto& [newRuleCard, newHand, newPalette] = move;
+
+    StateMasks state;
+    state.rule = 1ULL << getCardIndex(newRuleCard);
+    state.hand = cardsToMask(newHand);
+    state.palette = cardsToMask(newPalette);
+    state.otherPalettes = otherPalettesMask;
+    state.deck = kDeckMask & ~(state.hand | state.palette | othersOccupiedMask);
+    return state;
+}
+
+enum Activation {
+    Linear = 0,
+    ReLU = 1,
+    Sigmoid = 2
+};
+
+struct DenseLayer {
+    int inputs = 0;
+    int outputs = 0;
+    int stride = 0;  // outputs, округлённое вверх до 8 (ширина регистра AVX)
+    Activation activation = Linear;
+    std::vector<float> weights;  // [inputs][stride], хвост строки заполнен нулями
+    std::vector<float> bias;     // [stride]
+};
+
+// y[0..n) += x[0..n), n кратно 8
+inline void addRow(const float* x, float* y, int n) {
+#ifdef RED7_NN_AVX2
+    for (int i = 0; i < n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+    }
+#else
+    for (int i = 0; i < n; ++i) {
+        y[i] += x[i];
+    }
+#endif
+}
+
+// out[b] = in[b] * W + bias для count <= 4 состояний; каждая строка весов загружается один раз на все состояния
+inline void denseBlock(const DenseLayer& layer, const float* in, int inStride, float* out, int count) {
+    const int n = layer.stride;
+    const float* w = layer.weights.data();
+
+#ifdef RED7_NN_AVX2
+    for (int j = 0; j < n; j += 8) {
+        __m256 bias = _mm256_loadu_ps(layer.bias.data() + j);
+        __m256 acc0 = bias, acc1 = bias, acc2 = bias, acc3 = bias;
+
+        for (int i = 0; i < layer.inputs; ++i) {
+            __m256 row = _mm256_loadu_ps(w + (size_t)i * n + j);
+            acc0 = _mm256_fmadd_ps(_mm256_set1_ps(in[i]), row, acc0);
+            if (count > 1) acc1 = _mm256_fmadd_ps(_mm256_set1_ps(in[inStride + i]), row, acc1);
+            if (count > 2) acc2 = _mm256_fmadd_ps(_mm256_set1_ps(in[2 * inStride + i]), row, acc2);
+            if (count > 3) acc3 = _mm256_fmadd_ps(_mm256_set1_ps(in[3 * inStride + i]), row, acc3);
+        }
+
+        _mm256_storeu_ps(out + j, acc0);
+        if (count > 1) _mm256_storeu_ps(out + n + j, acc1);
+        if (count > 2) _mm256_storeu_ps(out + 2 * n + j, acc2);
+        if (count > 3) _mm256_storeu_ps(out + 3 * n + j, acc3);
+    }
+#else
+    for (int b = 0; b < count; ++b) {
+        float* y = out + (size_t)b * n;
+        const float* x = in + (size_t)b * inStride;
+        std::memcpy(y, layer.bias.data(), sizeof(float) * n);
+        for (int i = 0; i < layer.inputs; ++i) {
+            const float a = x[i];
+            const float* row = w + (size_t)i * n;
+            for (int j = 0; j < n; ++j) {
+                y[j] += a * row[j];
+            }
+        }
+    }
+#endif
+}
+
+inline void applyActivation(Activation activation, float* values, int n) {
+    if (activation == ReLU) {
+#ifdef RED7_NN_AVX2
+        const __m256 zero = _mm256_setzero_ps();
+        for (int i = 0; i < n; i += 8) {
+            _mm256_storeu_ps(values + i, _mm256_max_ps(_mm256_loadu_ps(values + i), zero));
+        }
+#else
+        for (int i = 0; i < n; ++i) {
+            values[i] = values[i] > 0.0f ? values[i] : 0.0f;
+        }
+#endif
+    } else if (activation == Sigmoid) {
+        for (int i = 0; i < n; ++i) {
+            values[i] = 1.0f / (1.0f + std::exp(-values[i]));
+        }
+    }
+}
+
+class MlpModel {
+public:
+    static MlpModel loadFromFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("Не удалось открыть файл весов " + path);
+        }
+
+        char magic[4];
+        uint32_t version = 0, numLayers = 0;
+        in.read(magic, 4);
+        in.read(reinterpret_cast<char*>(&version), sizeof(version));
+        in.read(reinterpret_cast<char*>(&numLayers), sizeof(numLayers));
+        if (!in || std::memcmp(magic, "R7NN", 4) != 0 || version != 1) {
+            throw std::runtime_error("Неверный формат файла весов " + path);
+        }
+        if (numLayers == 0) {
+            throw std::runtime_error("В модели нет слоёв");
+        }
+
+        MlpModel model;
+        for (uint32_t l = 0; l < numLayers; ++l) {
+            uint32_t header[3];
+            in.read(reinterpret_cast<char*>(header), sizeof(header));
+
+            DenseLayer layer;
+            layer.inputs = (int)header[0];
+            layer.outputs = (int)header[1];
+            layer.stride = (layer.outputs + 7) / 8 * 8;
+            layer.activation = static_cast<Activation>(header[2]);
+
+            int expectedInputs = l == 0 ? kStateBits : model.layers.back().outputs;
+            if (!in || layer.inputs != expectedInputs || layer.outputs <= 0 || header[2] > Sigmoid) {
+                throw std::runtime_error("Неверный заголовок слоя " + std::to_string(l));
+            }
+
+            layer.weights.assign((size_t)layer.inputs * layer.stride, 0.0f);
+            layer.bias.assign(layer.stride, 0.0f);
+            for (int i = 0; i < layer.inputs; ++i) {
+                in.read(reinterpret_cast<char*>(&layer.weights[(size_t)i * layer.stride]), sizeof(float) * layer.outputs);
+            }
+            in.read(reinterpret_cast<char*>(layer.bias.data()), sizeof(float) * layer.outputs);
+            if (!in) {
+                throw std::runtime_error("Файл весов обрезан на слое " + std::to_string(l));
+            }
+
+            model.maxStride = std::max(model.maxStride, layer.stride);
+            model.layers.push_back(std::move(layer));
+        }
+
+        if (model.layers.back().outputs != 1) {
+            throw std::runtime_error("Последний слой должен иметь один выход");
+        }
+        return model;
+    }
+
+    // Возвращает оценку (вероятность победы) для каждого состояния пакета
+    std::vector<float> predict(const std::vector<StateMasks>& batch) {
+        const int count = (int)batch.size();
+        std::vector<float> scores(count);
+        if (count == 0) return scores;
+
+        bufferA.resize((size_t)count * maxStride);
+        bufferB.resize((size_t)count * maxStride);
+
+        // Первый слой: вход one-hot, поэтому вместо умножения складываем строки весов установленных битов
+        const DenseLayer& first = layers[0];
+        for (int b = 0; b < count; ++b) {
+            float* y = &bufferA[(size_t)b * first.stride];
+            std::memcpy(y, first.bias.data(), sizeof(float) * first.stride);
+
+            const uint64_t fields[kStateFields] = {
+                batch[b].rule, batch[b].hand, batch[b].palette, batch[b].otherPalettes, batch[b].deck
+            };
+            for (int f = 0; f < kStateFields; ++f) {
+                uint64_t mask = fields[f];
+                while (mask) {
+                    int bit = f * 50 + __builtin_ctzll(mask);
+                    addRow(&first.weights[(size_t)bit * first.stride], y, first.stride);
+                    mask &= mask - 1;
+                }
+            }
+            applyActivation(first.activation, y, first.stride);
+        }
+
+        float* in = bufferA.data();
+        float* out = bufferB.data();
+        int inStride = first.stride;
+        for (size_t l = 1; l < layers.size(); ++l) {
+            const DenseLayer& layer = layers[l];
+            for (int b = 0; b < count; b += 4) {
+                int blockCount = std::min(4, count - b);
+                denseBlock(layer, in + (size_t)b * inStride, inStride, out + (size_t)b * layer.stride, blockCount);
+            }
+            applyActivation(layer.activation, out, count * layer.stride);
+            std::swap(in, out);
+            inStride = layer.stride;
+        }
+
+        for (int b = 0; b < count; ++b) {
+            scores[b] = in[(size_t)b * inStride];
+        }
+        return scores;
+    }
+
+private:
+    std::vector<DenseLayer> layers;
+    int maxStride = 0;
+    std::vector<float> bufferA;
+    std::vector<float> bufferB;
+};
+
+// Индекс лучшего хода или -1, если ходов нет
+inline int chooseBestMove(
+    MlpModel& model,
+    const std::vector<std::tuple<Card, std::vector<Card>, std::vector<Card>>>& moves,
+    uint64_t otherPalettesMask,
+    uint64_t othersOccupiedMask
+) {
+    if (moves.empty()) return -1;
+
+    std::vector<StateMasks> batch;
+    batch.reserve(moves.size());
+    for (const auto& move : moves) {
+        batch.push_back(encodeCandidateMove(move, otherPalettesMask, othersOccupiedMask));
+    }
+
+    std::vector<float> scores = model.predict(batch);
+    return (int)(std::max_element(scores.begin(), scores.end()) - scores.begin());
+}
+
+#endif // GAME_7_RED_INFERENCE_H
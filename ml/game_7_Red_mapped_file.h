@@ -0,0 +1,90 @@
+/*
+    Red7 Read-Only Mapped File
+
+    Описание(ru):
+    Общее отображение файла в память только для чтения для двоичных форматов ml/:
+    упакованного датасета (game_7_Red_packed_dataset.h), файла партий (game_7_Red_replay.h),
+    таблицы эндшпилей (game_7_Red_tablebase.h) и таблицы оценок палитр (game_7_Red_score_cache.h).
+    Файл открывается, проверяется минимальный размер (заголовок формата), отображается через
+    mmap(PROT_READ, MAP_PRIVATE) и освобождается в деструкторе — читатели форматов хранят
+    MappedFile членом класса и проверяют только своё содержимое.
+
+    Основные компоненты:
+    - MappedFile(path, minSize): открывает и отображает файл; std::runtime_error при ошибке
+        или если файл меньше minSize байт.
+    - MappedFile::bytes / size: начало отображения и его размер.
+    - MappedFile::adviseSequential: подсказка ядру о последовательном чтении (MADV_SEQUENTIAL).
+*/
+
+/*
+    Red7 Read-Only Mapped File
+
+    Description(eng):
+    A shared read-only memory mapping for the binary formats in ml/:
+    the packed dataset (game_7_Red_packed_dataset.h), the games file (game_7_Red_replay.h),
+    the endgame tablebase (game_7_Red_tablebase.h) and the palette score table (game_7_Red_score_cache.h).
+    The file is opened, checked against a minimum size (the format header), mapped through
+    mmap(PROT_READ, MAP_PRIVATE) and released in the destructor — format readers keep
+    a MappedFile member and only validate their own contents.
+
+    Main components:
+    - MappedFile(path, minSize): opens and maps the file; std::runtime_error on failure
+        or when the file is smaller than minSize bytes.
+    - MappedFile::bytes / size: the start of the mapping and its size.
+    - MappedFile::adviseSequential: tells the kernel the file will be read sequentially (MADV_SEQUENTIAL).
+*/
+
+#ifndef GAME_7_RED_MAPPED_FILE_H
+#define GAME_7_RED_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+    MappedFile(const std::string& path, size_t minSize) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Не удалось открыть " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < minSize || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("Файл " + path + " слишком мал");
+        }
+        length = st.st_size;
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Не удалось отобразить " + path + " в память");
+        }
+        data = static_cast<const uint8_t*>(mapped);
+    }
+
+    ~MappedFile() {
+        munmap(const_cast<uint8_t*>(data), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* bytes() const { return data; }
+    size_t size() const { return length; }
+
+    void adviseSequential() const {
+        madvise(const_cast<uint8_t*>(data), length, MADV_SEQUENTIAL);
+    }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+};
+
+#endif // GAME_7_RED_MAPPED_FILE_H
@@ -0,0 +1,297 @@
+/*
+    Red7 Packed Dataset Format
+
+    Описание(ru):
+    Бинарное представление файла dataset.txt: каждая строка датасета хранится как шесть
+    64-битных слов вместо ~260 символов текста. Данные разбиты на блоки по kPackedBlockRows строк,
+    внутри блока каждый столбец лежит непрерывно (column-major), что позволяет сканировать
+    только нужные столбцы и обрабатывать их векторными инструкциями.
+
+    Основные компоненты:
+    - PackedRow: одна строка датасета (rule, hand, palette, otherPalettes, deck, meta).
+    - packMeta / metaRound / metaPlayer / metaGame: упаковка числовых полей и флагов в слово meta.
+    - parseDatasetLine / formatDatasetLine: перевод между текстовой строкой и PackedRow.
+    - PackedDatasetWriter: потоковая запись упакованного файла.
+    - PackedDatasetReader: чтение через mmap только для чтения.
+
+    Формат файла (little-endian):
+        char[4]  magic = "R7PK"
+        uint32   version = 1
+        uint32   blockRows
+        uint32   reserved
+        uint64   rowCount
+        uint64   blockCount
+        затем blockCount блоков одинакового размера, в каждом 6 столбцов по blockRows слов uint64
+        (последний блок дополнен нулями).
+    Поддерживается только 10-полевой формат dataset.txt: строки с раздельными палитрами соперников
+    (12 полей, --per-opponent-palettes) parseDatasetLine отклоняет, и при упаковке они считаются пропущенными.
+
+    Раскладка слова meta:
+        биты 0–15  — roundNumber
+        биты 16–23 — playerNumber
+        бит 24     — eliminatedFlag
+        бит 25     — winFlag
+        биты 32–63 — gameNumber
+*/
+
+/*
+    Red7 Packed Dataset Format
+
+    Description(eng):
+    A binary representation of dataset.txt: each dataset line is stored as six 64-bit words
+    instead of ~260 characters of text. The data is split into blocks of kPackedBlockRows lines,
+    and inside a block each column is stored contiguously (column-major), so that a scan only
+    touches the columns it needs and can process them with vector instructions.
+
+    Main components:
+    - PackedRow: one dataset line (rule, hand, palette, otherPalettes, deck, meta).
+    - packMeta / metaRound / metaPlayer / metaGame: pack the numeric fields and flags into the meta word.
+    - parseDatasetLine / formatDatasetLine: convert between a text line and a PackedRow.
+    - PackedDatasetWriter: streaming writer for the packed file.
+    - PackedDatasetReader: reader based on a read-only mmap.
+
+    File format (little-endian):
+        char[4]  magic = "R7PK"
+        uint32   version = 1
+        uint32   blockRows
+        uint32   reserved
+        uint64   rowCount
+        uint64   blockCount
+        followed by blockCount equally sized blocks, each holding 6 columns of blockRows uint64 words
+        (the last block is padded with zeros).
+    Only the 10-field dataset.txt format is supported: parseDatasetLine rejects lines with separate
+    opponent palettes (12 fields, --per-opponent-palettes), and packing counts them as skipped.
+
+    Meta word layout:
+        bits 0–15  — roundNumber
+        bits 16–23 — playerNumber
+        bit 24     — eliminatedFlag
+        bit 25     — winFlag
+        bits 32–63 — gameNumber
+*/
+
+#ifndef GAME_7_RED_PACKED_DATASET_H
+#define GAME_7_RED_PACKED_DATASET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "game_7_Red_mapped_file.h"
+#include "game_7_Red_rules.h"
+
+const uint32_t kPackedBlockRows = 65536;
+const int kPackedColumns = 6;
+
+enum PackedColumn {
+    ColumnRule = 0,
+    ColumnHand = 1,
+    ColumnPalette = 2,
+    ColumnOtherPalettes = 3,
+    ColumnDeck = 4,
+    ColumnMeta = 5
+};
+
+const uint64_t kMetaEliminatedBit = 1ULL << 24;
+const uint64_t kMetaWonBit = 1ULL << 25;
+
+struct PackedDatasetHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t blockRows;
+    uint32_t reserved;
+    uint64_t rowCount;
+    uint64_t blockCount;
+};
+
+struct PackedRow {
+    uint64_t columns[kPackedColumns];
+};
+
+inline uint64_t packMeta(uint32_t game, uint32_t round, uint32_t player, bool eliminated, bool won) {
+    return (uint64_t)game << 32 | (uint64_t)(player & 0xFF) << 16 | (round & 0xFFFF) |
+           (eliminated ? kMetaEliminatedBit : 0) | (won ? kMetaWonBit : 0);
+}
+
+inline uint32_t metaRound(uint64_t meta) { return meta & 0xFFFF; }
+inline uint32_t metaPlayer(uint64_t meta) { return meta >> 16 & 0xFF; }
+inline uint32_t metaGame(uint64_t meta) { return meta >> 32; }
+
+// Строка из 50 символов '0'/'1' -> маска (бит i = символ i)
+inline bool binaryToMask(const char* text, size_t length, uint64_t& mask) {
+    if (length != 50) return false;
+    mask = 0;
+    for (int i = 0; i < 50; ++i) {
+        if (text[i] == '1') mask |= 1ULL << i;
+        else if (text[i] != '0') return false;
+    }
+    return true;
+}
+
+inline bool parseDatasetLine(const std::string& line, PackedRow& row) {
+    const char* fields[10];
+    size_t lengths[10];
+    int count = 0;
+    size_t start = 0, end = 0;
+    while (count < 10) {
+        end = line.find(',', start);
+        if (end == std::string::npos) end = line.size();
+        fields[count] = line.data() + start;
+        lengths[count] = end - start;
+        ++count;
+        if (end == line.size()) break;
+        start = end + 1;
+    }
+    // лишние поля (например, строки с раздельными палитрами соперников) не подходят под формат
+    if (count != 10 || end != line.size()) return false;
+
+    for (int f = 0; f < 5; ++f) {
+        if (!binaryToMask(fields[3 + f], lengths[3 + f], row.columns[f])) return false;
+    }
+
+    uint32_t game = (uint32_t)std::strtoul(fields[0], nullptr, 10);
+    uint32_t round = (uint32_t)std::strtoul(fields[1], nullptr, 10);
+    uint32_t player = (uint32_t)std::strtoul(fields[2], nullptr, 10);
+    row.columns[ColumnMeta] = packMeta(game, round, player, fields[8][0] == '1', fields[9][0] == '1');
+    return true;
+}
+
+// Та же строка, что пишет playFullGame, без завершающего '\n'
+inline std::string formatDatasetLine(const PackedRow& row) {
+    uint64_t meta = row.columns[ColumnMeta];
+    std::string line = std::to_string(metaGame(meta)) + "," + std::to_string(metaRound(meta)) + "," +
+                       std::to_string(metaPlayer(meta));
+    for (int f = 0; f < 5; ++f) {
+        line += "," + maskToBinary(row.columns[f]);
+    }
+    line += (meta & kMetaEliminatedBit) ? ",1" : ",0";
+    line += (meta & kMetaWonBit) ? ",1" : ",0";
+    return line;
+}
+
+class PackedDatasetWriter {
+public:
+    explicit PackedDatasetWriter(const std::string& path) : block(kPackedColumns * (size_t)kPackedBlockRows, 0) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Не удалось открыть " + path + " для записи");
+        }
+        PackedDatasetHeader header = makeHeader();
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            std::fclose(file);
+            throw std::runtime_error("Ошибка записи в " + path);
+        }
+    }
+
+    ~PackedDatasetWriter() {
+        if (!file) return;
+        try {
+            close();
+        } catch (const std::exception&) {
+        }
+        if (file) std::fclose(file);
+    }
+
+    PackedDatasetWriter(const PackedDatasetWriter&) = delete;
+    PackedDatasetWriter& operator=(const PackedDatasetWriter&) = delete;
+
+    void append(const PackedRow& row) {
+        for (int c = 0; c < kPackedColumns; ++c) {
+            block[(size_t)c * kPackedBlockRows + rowsInBlock] = row.columns[c];
+        }
+        ++rowCount;
+        if (++rowsInBlock == kPackedBlockRows) flushBlock();
+    }
+
+    void close() {
+        if (rowsInBlock > 0) flushBlock();
+        PackedDatasetHeader header = makeHeader();
+        bool written = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+        written = std::fclose(file) == 0 && written;
+        file = nullptr;
+        if (!written) {
+            throw std::runtime_error("Ошибка записи упакованного датасета");
+        }
+    }
+
+    uint64_t rows() const { return rowCount; }
+
+private:
+    PackedDatasetHeader makeHeader() const {
+        PackedDatasetHeader header;
+        std::memcpy(header.magic, "R7PK", 4);
+        header.version = 1;
+        header.blockRows = kPackedBlockRows;
+        header.reserved = 0;
+        header.rowCount = rowCount;
+        header.blockCount = blockCount;
+        return header;
+    }
+
+    void flushBlock() {
+        for (int c = 0; c < kPackedColumns; ++c) {
+            uint64_t* column = &block[(size_t)c * kPackedBlockRows];
+            std::fill(column + rowsInBlock, column + kPackedBlockRows, 0);
+        }
+        if (std::fwrite(block.data(), sizeof(uint64_t), block.size(), file) != block.size()) {
+            throw std::runtime_error("Ошибка записи упакованного датасета");
+        }
+        ++blockCount;
+        rowsInBlock = 0;
+    }
+
+    std::FILE* file = nullptr;
+    std::vector<uint64_t> block;
+    uint32_t rowsInBlock = 0;
+    uint64_t rowCount = 0;
+    uint64_t blockCount = 0;
+};
+
+class PackedDatasetReader {
+public:
+    explicit PackedDatasetReader(const std::string& path) : file(path, sizeof(PackedDatasetHeader)) {
+        std::memcpy(&header, file.bytes(), sizeof(header));
+        size_t expected = sizeof(header) + header.blockCount * kPackedColumns * (size_t)header.blockRows * sizeof(uint64_t);
+        if (std::memcmp(header.magic, "R7PK", 4) != 0 || header.version != 1 || header.blockRows == 0 || file.size() < expected) {
+            throw std::runtime_error("Неверный формат упакованного датасета " + path);
+        }
+        file.adviseSequential();
+    }
+
+    PackedDatasetReader(const PackedDatasetReader&) = delete;
+    PackedDatasetReader& operator=(const PackedDatasetReader&) = delete;
+
+    uint64_t rowCount() const { return header.rowCount; }
+    uint64_t blockCount() const { return header.blockCount; }
+    uint32_t blockRows() const { return header.blockRows; }
+
+    // Число заполненных строк в блоке
+    uint32_t rowsInBlock(uint64_t block) const {
+        uint64_t begin = block * header.blockRows;
+        return (uint32_t)std::min<uint64_t>(header.blockRows, header.rowCount - begin);
+    }
+
+    const uint64_t* column(uint64_t block, int column) const {
+        const uint64_t* base = reinterpret_cast<const uint64_t*>(file.bytes() + sizeof(header));
+        return base + (block * kPackedColumns + column) * header.blockRows;
+    }
+
+    PackedRow row(uint64_t block, uint32_t index) const {
+        PackedRow result;
+        for (int c = 0; c < kPackedColumns; ++c) {
+            result.columns[c] = column(block, c)[index];
+        }
+        return result;
+    }
+
+private:
+    MappedFile file;
+    PackedDatasetHeader header;
+};
+
+#endif // GAME_7_RED_PACKED_DATASET_H
@@ -0,0 +1,403 @@
+/*
+    Red7 Compact Replay Format
+
+    Описание(ru):
+    Компактный формат записи партий: вместо 250-битного состояния на каждый ход хранятся
+    seed партии, число игроков, размер руки и последовательность ходов по 1 байту. Раздача
+    не хранится — она повторяется по seed той же функцией dealHands, что и в генераторе.
+    Строки датасета в формате dataset.txt восстанавливаются по требованию (reconstructGame)
+    повторным проигрыванием ходов без вызова getWinningMoves.
+
+    Основные компоненты:
+    - GameRow / encodeGameRow / finishGameRows: строка датасета, общая для генератора и восстановления.
+    - encodeReplayMove: байт хода по состоянию до хода и выбранному ходу из getWinningMoves.
+    - dealHands / replayDeal: раздача по генератору партии, общая для генератора и восстановления.
+    - ReplayWriter: потоковая запись файла партий.
+    - ReplayReader: чтение через mmap только для чтения с индексом смещений партий
+        (партии можно восстанавливать параллельно).
+    - reconstructGame: восстанавливает строки партии, совпадающие байт в байт с simulateGame.
+
+    Байт хода (позиция — номер карты в руке до хода, упорядоченной по индексу карт):
+        биты 7–6 — тип: 0 = карта в палитру, 1 = смена правила, 2 = палитра и правило, 3 = игрок выбывает
+        биты 5–3 — позиция карты, которая кладётся в палитру
+        биты 2–0 — позиция карты, которая становится правилом
+
+    Формат файла (little-endian, varint — LEB128 без знака):
+        char[4]  magic = "R7RP"
+        uint32   version = 2
+        затем партии подряд:
+            varint   recordBytes  — длина записи партии после этого поля
+            varint   gameNumberDelta — gameNumber минус (номер предыдущей партии + 1)
+            uint32   seed         — seed std::mt19937 партии: раздача dealHands(numPlayers, handSize)
+            uint8    numPlayers
+            uint8    handSize
+            varint   moveCount
+            uint8    moves[moveCount]
+    Раздача зависит от std::shuffle, поэтому файл восстанавливается той же стандартной библиотекой,
+    которой он записан.
+*/
+
+/*
+    Red7 Compact Replay Format
+
+    Description(eng):
+    A compact format for recording games: instead of a 250-bit state per move, it stores
+    the game seed, the number of players, the hand size and a sequence of 1-byte moves. The deal
+    is not stored — it is repeated from the seed by the same dealHands function the generator uses.
+    Dataset lines in the dataset.txt format are reconstructed on demand (reconstructGame)
+    by replaying the moves, without calling getWinningMoves.
+
+    Main components:
+    - GameRow / encodeGameRow / finishGameRows: a dataset line shared by the generator and the reconstruction.
+    - encodeReplayMove: the move byte given the state before the move and the move chosen from getWinningMoves.
+    - dealHands / replayDeal: the deal from the game's generator, shared by the generator and the reconstruction.
+    - ReplayWriter: streaming writer for the games file.
+    - ReplayReader: reader based on a read-only mmap with an index of game offsets
+        (games can be reconstructed in parallel).
+    - reconstructGame: restores the lines of a game, byte-for-byte identical to simulateGame.
+
+    Move byte (a slot is the card's position in the hand before the move, ordered by card index):
+        bits 7–6 — type: 0 = card to palette, 1 = rule change, 2 = palette and rule, 3 = player is eliminated
+        bits 5–3 — slot of the card put into the palette
+        bits 2–0 — slot of the card that becomes the rule
+
+    File format (little-endian, varint — unsigned LEB128):
+        char[4]  magic = "R7RP"
+        uint32   version = 2
+        followed by the games:
+            varint   recordBytes  — length of the game record after this field
+            varint   gameNumberDelta — gameNumber minus (previous game number + 1)
+            uint32   seed         — the game's std::mt19937 seed: the deal is dealHands(numPlayers, handSize)
+            uint8    numPlayers
+            uint8    handSize
+            varint   moveCount
+            uint8    moves[moveCount]
+    The deal depends on std::shuffle, so a file is reconstructed with the same standard library
+    it was written with.
+*/
+
+#ifndef GAME_7_RED_REPLAY_H
+#define GAME_7_RED_REPLAY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "game_7_Red_mapped_file.h"
+#include "game_7_Red_rules.h"
+
+// Одна строка датасета вместе с полями, по которым её можно отнести к страте
+struct GameRow {
+    std::string line;      // готовая строка, включая флаг победы и '\n'
+    int playerIndex;
+    int round;
+    Color rule;
+    int handSize;
+};
+
+// Строка состояния игрока i без флага победы (он известен только в конце партии)
+inline GameRow encodeGameRow(int gameNumber, int round, int i, const Card& ruleCard,
+                             const std::vector<std::vector<Card>>& hands,
+                             const std::vector<std::vector<Card>>& palettes,
+                             const std::vector<bool>& active, bool eliminated) {
+    std::stringstream ss;
+    ss << gameNumber << "," << round << "," << (i + 1) << ",";
+    ss << ruleCardToBinary(ruleCard) << ",";
+    ss << cardsToBinaryArray(hands[i]) << ",";
+    ss << cardsToBinaryArray(palettes[i]) << ",";
+    ss << otherPalettesToBinary(palettes, i, active) << ",";
+    ss << deckCardsToBinary(hands, palettes, active);
+    ss << (eliminated ? ",1" : ",0");
+    return {ss.str(), i, round, ruleCard.getColor(), (int)hands[i].size()};
+}
+
+inline void finishGameRows(std::vector<GameRow>& rows, int finalWinner) {
+    for (auto& row : rows) {
+        if (row.playerIndex == finalWinner)
+            row.line += ",1\n";  // победил
+        else
+            row.line += ",0\n";  // не победил
+    }
+}
+
+const uint8_t kReplayToPalette = 0;
+const uint8_t kReplayToRule = 1;
+const uint8_t kReplayToBoth = 2;
+const uint8_t kReplayEliminated = 3 << 6;
+
+inline uint8_t encodeReplayMove(const std::vector<Card>& handBefore, const std::vector<Card>& paletteBefore,
+                                const Card& ruleBefore,
+                                const std::tuple<Card, std::vector<Card>, std::vector<Card>>& move) {
+    const auto& [newRuleCard, newHand, newPalette] = move;
+
+    // Позиция карты в руке, упорядоченной по индексу карт: порядок карт в руке на строки не влияет
+    auto slotOf = [&](const Card& card) {
+        int index = getCardIndex(card);
+        int slot = 0;
+        for (const auto& c : handBefore) {
+            if (getCardIndex(c) < index) ++slot;
+        }
+        if (slot > 7) throw std::runtime_error("В руке больше 8 карт — ход не помещается в байт");
+        return (uint8_t)slot;
+    };
+
+    bool toPalette = newPalette.size() > paletteBefore.size();
+    bool toRule = getCardIndex(newRuleCard) != getCardIndex(ruleBefore);
+    uint8_t paletteSlot = toPalette ? slotOf(newPalette.back()) : 0;
+    uint8_t ruleSlot = toRule ? slotOf(newRuleCard) : 0;
+    uint8_t type = toPalette && toRule ? kReplayToBoth : (toRule ? kReplayToRule : kReplayToPalette);
+    return (uint8_t)(type << 6 | paletteSlot << 3 | ruleSlot);
+}
+
+// Раздача: колода перемешивается генератором партии, игрок p получает карты [p * handSize, (p + 1) * handSize),
+// остальные карты (в порядке колоды) записываются в rest, если он задан
+inline std::vector<std::vector<Card>> dealHands(int numPlayers, int handSize, std::mt19937& rng,
+                                                std::vector<Card>* rest = nullptr) {
+    std::vector<Card> deck = createFullDeck();
+    std::shuffle(deck.begin(), deck.end(), rng);
+
+    std::vector<std::vector<Card>> hands(numPlayers);
+    for (int player = 0; player < numPlayers; ++player) {
+        hands[player].assign(deck.begin() + player * handSize, deck.begin() + (player + 1) * handSize);
+    }
+    if (rest) {
+        rest->assign(deck.begin() + numPlayers * handSize, deck.end());
+    }
+    return hands;
+}
+
+struct ReplayGame {
+    uint32_t gameNumber = 0;
+    uint32_t seed = 0;
+    uint8_t numPlayers = 2;
+    uint8_t handSize = 7;
+    std::vector<uint8_t> moves;
+};
+
+// Руки партии в порядке раздачи, как их получил simulateGame
+inline std::vector<std::vector<Card>> replayDeal(const ReplayGame& game) {
+    std::mt19937 rng(game.seed);
+    return dealHands(game.numPlayers, game.handSize, rng);
+}
+
+inline void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+inline uint64_t readVarint(const uint8_t*& p, const uint8_t* end) {
+    uint64_t value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error("Повреждённый varint в файле партий");
+}
+
+class ReplayWriter {
+public:
+    explicit ReplayWriter(const std::string& path) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Не удалось открыть " + path + " для записи");
+        }
+        uint32_t version = 2;
+        if (std::fwrite("R7RP", 1, 4, file) != 4 || std::fwrite(&version, sizeof(version), 1, file) != 1) {
+            std::fclose(file);
+            throw std::runtime_error("Ошибка записи в " + path);
+        }
+    }
+
+    ~ReplayWriter() {
+        if (!file) return;
+        try {
+            close();
+        } catch (const std::exception&) {
+        }
+    }
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    void append(const ReplayGame& game) {
+        if ((int64_t)game.gameNumber <= previousGame) {
+            throw std::runtime_error("Номера партий в файле должны возрастать");
+        }
+        record.clear();
+        appendVarint(record, game.gameNumber - (uint64_t)(previousGame + 1));
+        for (int b = 0; b < 4; ++b) record.push_back((uint8_t)(game.seed >> (8 * b)));
+        record.push_back(game.numPlayers);
+        record.push_back(game.handSize);
+        appendVarint(record, game.moves.size());
+        record.insert(record.end(), game.moves.begin(), game.moves.end());
+
+        prefix.clear();
+        appendVarint(prefix, record.size());
+        if (std::fwrite(prefix.data(), 1, prefix.size(), file) != prefix.size() ||
+            std::fwrite(record.data(), 1, record.size(), file) != record.size()) {
+            throw std::runtime_error("Ошибка записи файла партий");
+        }
+        bytesWritten += prefix.size() + record.size();
+        previousGame = game.gameNumber;
+    }
+
+    void close() {
+        bool closed = std::fclose(file) == 0;
+        file = nullptr;
+        if (!closed) {
+            throw std::runtime_error("Ошибка записи файла партий");
+        }
+    }
+
+    uint64_t bytes() const { return bytesWritten; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> record;
+    std::vector<uint8_t> prefix;
+    uint64_t bytesWritten = 0;
+    int64_t previousGame = -1;
+};
+
+class ReplayReader {
+public:
+    explicit ReplayReader(const std::string& path) : file(path, 8) {
+        const uint8_t* data = file.bytes();
+        uint32_t version = 0;
+        std::memcpy(&version, data + 4, sizeof(version));
+        if (std::memcmp(data, "R7RP", 4) != 0 || version != 2) {
+            throw std::runtime_error("Неверный формат файла партий " + path);
+        }
+
+        // Индекс: один быстрый проход по длинам записей и номерам партий
+        const uint8_t* p = data + 8;
+        const uint8_t* end = data + file.size();
+        while (p < end) {
+            uint64_t recordBytes = readVarint(p, end);
+            if ((uint64_t)(end - p) < recordBytes) {
+                throw std::runtime_error("Файл партий " + path + " обрезан");
+            }
+            const uint8_t* record = p;
+            int64_t previousGame = gameNumbers.empty() ? -1 : (int64_t)gameNumbers.back();
+            gameNumbers.push_back((uint32_t)(previousGame + 1 + readVarint(record, p + recordBytes)));
+            offsets.push_back(record - data);
+            lengths.push_back(recordBytes - (record - p));
+            p += recordBytes;
+        }
+    }
+
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    size_t games() const { return offsets.size(); }
+    uint64_t bytes() const { return file.size(); }
+
+    ReplayGame game(size_t index) const {
+        const uint8_t* p = file.bytes() + offsets[index];
+        const uint8_t* end = p + lengths[index];
+
+        ReplayGame game;
+        game.gameNumber = gameNumbers[index];
+        if (end - p < 6) throw std::runtime_error("Повреждённая запись партии");
+        for (int b = 0; b < 4; ++b) game.seed |= (uint32_t)*p++ << (8 * b);
+        game.numPlayers = *p++;
+        game.handSize = *p++;
+        if (game.numPlayers < 2 || game.numPlayers > 4 || game.handSize < 1 || game.handSize > 8) {
+            throw std::runtime_error("Повреждённая запись партии");
+        }
+
+        uint64_t moveCount = readVarint(p, end);
+        if ((uint64_t)(end - p) < moveCount) throw std::runtime_error("Повреждённая запись партии");
+        game.moves.assign(p, p + moveCount);
+        return game;
+    }
+
+private:
+    MappedFile file;
+    std::vector<uint64_t> offsets;   // начало записи после номера партии
+    std::vector<uint64_t> lengths;
+    std::vector<uint32_t> gameNumbers;
+};
+
+// Повторяет ход игры из simulateGame, но ходы берутся из записи, а не из getWinningMoves
+inline std::vector<GameRow> reconstructGame(const ReplayGame& game) {
+    std::vector<std::vector<Card>> hands = replayDeal(game);
+    for (auto& hand : hands) {
+        std::sort(hand.begin(), hand.end(), [](const Card& a, const Card& b) { return getCardIndex(a) < getCardIndex(b); });
+    }
+    int numPlayers = (int)hands.size();
+    std::vector<std::vector<Card>> palettes(numPlayers);
+    Card ruleCard = Card(Red, 0);
+    std::vector<bool> active(numPlayers, true);
+    int round = 1;
+    size_t nextMove = 0;
+
+    std::vector<GameRow> rows;
+    rows.reserve(game.moves.size());
+
+    while (true) {
+        int activeCount = (int)std::count(active.begin(), active.end(), true);
+        if (activeCount == 1) {
+            int winner = (int)(std::find(active.begin(), active.end(), true) - active.begin());
+            finishGameRows(rows, winner);
+            return rows;
+        }
+
+        for (int i = 0; i < numPlayers; ++i) {
+            if (!active[i]) continue;
+            if (nextMove >= game.moves.size()) {
+                throw std::runtime_error("Запись партии " + std::to_string(game.gameNumber) + " обрывается");
+            }
+
+            uint8_t move = game.moves[nextMove++];
+            if (move == kReplayEliminated) {
+                if (std::count(active.begin(), active.end(), true) == 1) {
+                    // последний игрок не может сделать ход — но он побеждает
+                    rows.push_back(encodeGameRow(game.gameNumber, round, i, ruleCard, hands, palettes, active, false));
+                    finishGameRows(rows, i);
+                    return rows;
+                }
+                active[i] = false;
+                rows.push_back(encodeGameRow(game.gameNumber, round, i, ruleCard, hands, palettes, active, true));
+                continue;
+            }
+
+            uint8_t type = move >> 6;
+            size_t paletteSlot = move >> 3 & 7;
+            size_t ruleSlot = move & 7;
+            std::vector<Card>& hand = hands[i];
+            if ((type != kReplayToRule && paletteSlot >= hand.size()) || (type != kReplayToPalette && ruleSlot >= hand.size())) {
+                throw std::runtime_error("Неверный ход в записи партии " + std::to_string(game.gameNumber));
+            }
+
+            if (type == kReplayToPalette) {
+                palettes[i].push_back(hand[paletteSlot]);
+                hand.erase(hand.begin() + paletteSlot);
+            } else if (type == kReplayToRule) {
+                ruleCard = hand[ruleSlot];
+                hand.erase(hand.begin() + ruleSlot);
+            } else {
+                palettes[i].push_back(hand[paletteSlot]);
+                ruleCard = hand[ruleSlot];
+                hand.erase(hand.begin() + std::max(paletteSlot, ruleSlot));
+                hand.erase(hand.begin() + std::min(paletteSlot, ruleSlot));
+            }
+            rows.push_back(encodeGameRow(game.gameNumber, round, i, ruleCard, hands, palettes, active, false));
+        }
+
+        ++round;
+    }
+}
+
+#endif // GAME_7_RED_REPLAY_H
@@ -0,0 +1,550 @@
+/*
+    Red7 Rules and State Encoding
+
+    Описание(ru):
+    Общий заголовочный файл с правилами Red7 и кодированием состояния игры.
+    Используется генератором данных, движком инференса и другими инструментами,
+    чтобы все они опирались на одну и ту же реализацию правил и один и тот же формат битов.
+
+    Основные компоненты:
+    - enum Color, class Card: цвет и карта Red7.
+    - comparison_*: функции сравнения палитр по правилам каждого цвета.
+    - computeRuleScore / ruleScoreForMask: результат comparison_* одним числом; ruleScoreForMask сначала обращается
+        к подключённой таблице оценок (ruleScoreLookup, game_7_Red_score_cache.h).
+    - getWinningMoves: генерация всех возможных выигрышных ходов игрока.
+    - getWinningMovesForMasks: то же с палитрами соперников в виде масок (std::array при известном числе игроков).
+    - getCardIndex / cardFromIndex: отображение карты в индекс [0..49] и обратно.
+    - colorFromName / cardFromString: разбор цвета и карты из текста (например, из аргументов командной строки).
+    - cardsToBinaryArray / ruleCardToBinary / otherPalettesToBinary / deckCardsToBinary:
+        кодирование состояния в строки из 50 символов '0'/'1'.
+    - cardsToMask / cardsFromMask: то же кодирование в виде 64-битной маски (бит i = карта с индексом i).
+*/
+
+/*
+    Red7 Rules and State Encoding
+
+    Description(eng):
+    A shared header containing the Red7 rules and the game state encoding.
+    It is used by the data generator, the inference engine and the other tools,
+    so that they all rely on the same rules implementation and the same bit layout.
+
+    Main components:
+    - enum Color, class Card: a Red7 colour and card.
+    - comparison_*: functions for comparing palettes according to the rules of each colour.
+    - computeRuleScore / ruleScoreForMask: the comparison_* result as a single number; ruleScoreForMask first consults
+        the installed score table (ruleScoreLookup, game_7_Red_score_cache.h).
+    - getWinningMoves: generates all possible winning moves for the player.
+    - getWinningMovesForMasks: the same with opponent palettes as masks (std::array when the player count is known).
+    - getCardIndex / cardFromIndex: maps a card to its index [0..49] and back.
+    - colorFromName / cardFromString: parse a colour or a card from text (e.g. from command-line arguments).
+    - cardsToBinaryArray / ruleCardToBinary / otherPalettesToBinary / deckCardsToBinary:
+        encode the state as 50-character '0'/'1' strings.
+    - cardsToMask / cardsFromMask: the same encoding as a 64-bit mask (bit i = card with index i).
+*/
+
+#ifndef GAME_7_RED_RULES_H
+#define GAME_7_RED_RULES_H
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+enum Color {
+    Red = 0,
+    Orange = 1,
+    Yellow = 2,
+    Green = 3,
+    LightBlue = 4,
+    Blue = 5,
+    Violet = 6
+};
+
+inline std::string getColorName(Color color) {
+    switch (color) {
+        case Red:    return "Red";
+        case Orange: return "Orange";
+        case Yellow: return "Yellow";
+        case Green:  return "Green";
+        case LightBlue: return "LightBlue";
+        case Blue: return "Blue";
+        case Violet: return "Violet";
+        default:     return "Unknown";
+    }
+}
+
+// Обратное к getColorName; -1, если имя неизвестно
+inline int colorFromName(const std::string& name) {
+    for (int c = Red; c <= Violet; ++c) {
+        if (getColorName(static_cast<Color>(c)) == name) return c;
+    }
+    return -1;
+}
+
+class Card {
+public:
+    Card(Color c, int v) : color(c), value(v) {}
+    Card() : color(Red), value(0) {}
+
+    int getValue() const { return value; }
+    Color getColor() const { return color; }
+
+    std::string toString() const {
+        return getColorName(color) + " " + std::to_string(value);
+    }
+
+    bool operator<(const Card& other) const {
+        if (value != other.value)
+            return value < other.value;
+        return color > other.color;
+    }
+
+private:
+    Color color;
+    int value;
+};
+
+inline Card findMaxCard(const std::vector<Card>& cards) {
+    if (cards.empty()) {
+        throw std::runtime_error("Пустой вектор карт");
+    }
+
+    Card maxCard = cards[0];
+    for (const Card& c : cards) {
+        if (maxCard < c) {
+            maxCard = c;
+        }
+    }
+    return maxCard;
+}
+
+inline bool comparison_red(const std::vector<Card>& hand1, const std::vector<Card>& hand2) {
+    if (hand1.empty() || hand2.empty()) {
+        return false;
+    }
+    return findMaxCard(hand1) < findMaxCard(hand2);
+}
+
+inline std::tuple<int, Card> comparison_orange(const std::vector<Card>& cards) {
+    if (cards.empty()) {
+        throw std::runtime_error("Пустой вектор карт");
+    }
+
+    std::map<int, std::vector<Card>> groups;
+    for (const Card& c : cards) {
+        groups[c.getValue()].push_back(c);
+    }
+
+    int maxCount = 0;
+    Card maxCard = cards[0];
+
+    for (const auto& [value, group] : groups) {
+        int count = (int)group.size();
+        Card localMax = findMaxCard(group);
+
+        if (count > maxCount || (count == maxCount && maxCard < localMax)) {
+            maxCount = count;
+            maxCard = localMax;
+        }
+    }
+
+    return std::make_tuple(maxCount, maxCard);
+}
+
+inline std::tuple<int, Card> comparison_yellow(const std::vector<Card>& cards) {
+    if (cards.empty()) {
+        throw std::runtime_error("Пустой вектор карт");
+    }
+
+    std::map<Color, std::vector<Card>> groups;
+    for (const Card& c : cards) {
+        groups[c.getColor()].push_back(c);
+    }
+
+    int maxCount = 0;
+    Card maxCard = cards[0];
+
+    for (const auto& [color, group] : groups) {
+        int count = (int)group.size();
+        Card localMax = findMaxCard(group);
+
+        if (count > maxCount || (count == maxCount && maxCard < localMax)) {
+            maxCount = count;
+            maxCard = localMax;
+        }
+    }
+
+    return std::make_tuple(maxCount, maxCard);
+}
+
+inline std::tuple<int, Card> comparison_green(const std::vector<Card>& cards) {
+    std::vector<Card> filtered;
+    for (const Card& c : cards) {
+        if (c.getValue() % 2 == 0) {
+            filtered.push_back(c);
+        }
+    }
+    if (filtered.empty()) {
+        throw std::runtime_error("Нет чётных карт");
+    }
+
+    return std::make_tuple((int)filtered.size(), findMaxCard(filtered));
+}
+
+inline std::tuple<int, Card> comparison_lightblue(const std::vector<Card>& cards) {
+    std::set<Color> uniqueColors;
+    for (const Card& c : cards) {
+        uniqueColors.insert(c.getColor());
+    }
+    return std::make_tuple((int)uniqueColors.size(), findMaxCard(cards));
+}
+
+inline std::tuple<int, Card> comparison_blue(const std::vector<Card>& cards) {
+    if (cards.empty()) {
+        throw std::runtime_error("Пустой вектор карт");
+    }
+
+    std::vector<int> values;
+    for (const Card& c : cards) {
+        values.push_back(c.getValue());
+    }
+
+    std::sort(values.begin(), values.end());
+
+    int maxLen = 1, curLen = 1;
+    int maxEndValue = values[0];
+
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (values[i] == values[i - 1] + 1) {
+            ++curLen;
+            if (curLen > maxLen) {
+                maxLen = curLen;
+                maxEndValue = values[i];
+            }
+        } else if (values[i] != values[i - 1]) {
+            curLen = 1;
+        }
+    }
+
+    Card maxCard = cards[0];
+    bool found = false;
+
+    for (const Card& c : cards) {
+        if (c.getValue() == maxEndValue) {
+            if (!found || maxCard < c) {
+                maxCard = c;
+                found = true;
+            }
+        }
+    }
+
+    return std::make_tuple(maxLen, maxCard);
+}
+
+inline std::tuple<int, Card> comparison_violet(const std::vector<Card>& cards) {
+    std::vector<Card> filtered;
+    for (const Card& c : cards) {
+        if (c.getValue() < 4) {
+            filtered.push_back(c);
+        }
+    }
+
+    if (filtered.empty()) {
+        throw std::runtime_error("Нет карт с номиналом меньше 4");
+    }
+
+    return std::make_tuple((int)filtered.size(), findMaxCard(filtered));
+}
+
+// Результат comparison_* одним числом: count * 64 + ранг карты (value * 7 + 6 - color).
+// Порядок чисел совпадает с порядком кортежей (count, Card); 0 — палитра не проходит правило (исключение).
+inline int computeRuleScore(Color rule, const std::vector<Card>& cards) {
+    try {
+        std::tuple<int, Card> result;
+
+        if (rule == Red)            result = std::make_tuple(1, findMaxCard(cards));
+        else if (rule == Orange)    result = comparison_orange(cards);
+        else if (rule == Yellow)    result = comparison_yellow(cards);
+        else if (rule == Green)     result = comparison_green(cards);
+        else if (rule == LightBlue) result = comparison_lightblue(cards);
+        else if (rule == Blue)      result = comparison_blue(cards);
+        else if (rule == Violet)    result = comparison_violet(cards);
+
+        const auto& [count, card] = result;
+        return count * 64 + card.getValue() * 7 + (6 - card.getColor());
+    } catch (...) {
+        return 0;
+    }
+}
+
+// Необязательный источник готовых оценок (таблица game_7_Red_score_cache.h).
+// Возвращает -1, если палитры нет в таблице — тогда оценка считается через comparison_*.
+using RuleScoreLookup = int (*)(Color rule, uint64_t paletteMask);
+
+inline RuleScoreLookup& ruleScoreLookup() {
+    static RuleScoreLookup lookup = nullptr;
+    return lookup;
+}
+
+inline int getCardIndex(const Card& card);
+inline uint64_t cardsToMask(const std::vector<Card>& cards);
+inline std::vector<Card> cardsFromMask(uint64_t mask);
+
+// Оценка палитры, заданной маской
+inline int ruleScoreForMask(Color rule, uint64_t paletteMask) {
+    if (RuleScoreLookup lookup = ruleScoreLookup()) {
+        int score = lookup(rule, paletteMask);
+        if (score >= 0) return score;
+    }
+    return computeRuleScore(rule, cardsFromMask(paletteMask));
+}
+
+// getWinningMoves с палитрами соперников в виде масок (0 — нет палитры или соперник выбыл).
+// OpponentMasks — любой контейнер uint64_t; с std::array<uint64_t, N> цикл по соперникам
+// имеет известную на этапе компиляции границу. Порог каждого правила (лучшая оценка соперников)
+// считается один раз на вызов, а векторы руки и палитры строятся только для выигрышных ходов.
+// Ходы и их порядок совпадают с getWinningMoves.
+template <typename OpponentMasks>
+inline std::vector<std::tuple<Card, std::vector<Card>, std::vector<Card>>> getWinningMovesForMasks(
+    Card ruleCard,
+    const std::vector<Card>& hand,
+    const std::vector<Card>& myPalette,
+    const OpponentMasks& otherPaletteMasks
+) {
+    std::vector<std::tuple<Card, std::vector<Card>, std::vector<Card>>> results;
+
+    // Ход выигрышный, если палитра проходит правило и её оценка не ниже оценки каждой непустой
+    // палитры соперника; если палитра соперника не проходит правило, выиграть по нему нельзя (порог INT_MAX)
+    std::array<int, 7> thresholds;
+    thresholds.fill(-1);
+    auto thresholdFor = [&](Color rule) {
+        int& threshold = thresholds[rule];
+        if (threshold < 0) {
+            threshold = 1;
+            for (uint64_t opp : otherPaletteMasks) {
+                if (!opp) continue;
+                int oppScore = ruleScoreForMask(rule, opp);
+                if (oppScore == 0) {
+                    threshold = INT_MAX;
+                    break;
+                }
+                threshold = std::max(threshold, oppScore);
+            }
+        }
+        return threshold;
+    };
+    auto checkWin = [&](uint64_t paletteMask, Color rule) {
+        int threshold = thresholdFor(rule);
+        return threshold != INT_MAX && ruleScoreForMask(rule, paletteMask) >= threshold;
+    };
+
+    auto handWithout = [&](size_t i, size_t j) {
+        std::vector<Card> newHand;
+        newHand.reserve(hand.size());
+        for (size_t k = 0; k < hand.size(); ++k) {
+            if (k != i && k != j) newHand.push_back(hand[k]);
+        }
+        return newHand;
+    };
+    auto paletteWith = [&](size_t i) {
+        std::vector<Card> newPalette = myPalette;
+        newPalette.push_back(hand[i]);
+        return newPalette;
+    };
+
+    Color currentRule = ruleCard.getColor();
+    uint64_t paletteMask = cardsToMask(myPalette);
+    const size_t none = hand.size();
+
+    // 1. Одинарный ход — в палитру
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (checkWin(paletteMask | 1ULL << getCardIndex(hand[i]), currentRule)) {
+            results.push_back(std::make_tuple(ruleCard, handWithout(i, none), paletteWith(i)));
+        }
+    }
+
+    // 2. Одинарный ход — смена правила
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (checkWin(paletteMask, hand[i].getColor())) {
+            results.push_back(std::make_tuple(hand[i], handWithout(i, none), myPalette));
+        }
+    }
+
+    // 3. Двойной ход — и в палитру, и смена правила
+    for (size_t i = 0; i < hand.size(); ++i) {
+        uint64_t newPaletteMask = paletteMask | 1ULL << getCardIndex(hand[i]);
+        std::array<int, 7> verdicts;  // результат checkWin по цвету нового правила, -1 — ещё не считали
+        verdicts.fill(-1);
+
+        for (size_t j = 0; j < hand.size(); ++j) {
+            if (i == j) continue;
+
+            Color newRule = hand[j].getColor();
+            if (verdicts[newRule] < 0) verdicts[newRule] = checkWin(newPaletteMask, newRule);
+            if (verdicts[newRule]) {
+                results.push_back(std::make_tuple(hand[j], handWithout(i, j), paletteWith(i)));
+            }
+        }
+    }
+
+    return results;
+}
+
+inline std::vector<std::tuple<Card, std::vector<Card>, std::vector<Card>>> getWinningMoves(
+    Card ruleCard,
+    const std::vector<Card>& hand,
+    const std::vector<Card>& myPalette,
+    const std::vector<std::vector<Card>>& otherPalettes
+) {
+    std::vector<uint64_t> otherPaletteMasks;
+    otherPaletteMasks.reserve(otherPalettes.size());
+    for (const auto& opp : otherPalettes) {
+        otherPaletteMasks.push_back(cardsToMask(opp));
+    }
+    return getWinningMovesForMasks(ruleCard, hand, myPalette, otherPaletteMasks);
+}
+
+inline std::vector<Card> createFullDeck() {
+    std::vector<Card> deck;
+    for (int color = 0; color <= 6; ++color) {
+        for (int value = 1; value <= 7; ++value) {
+            deck.emplace_back(static_cast<Color>(color), value);
+        }
+    }
+    return deck;
+}
+
+inline int getCardIndex(const Card& card) {
+    if (card.getColor() == Red && card.getValue() == 0) {
+        return 49;
+    } else {
+        return static_cast<int>(card.getColor()) * 7 + card.getValue() - 1;
+    }
+}
+
+inline Card cardFromIndex(int index) {
+    if (index == 49) {
+        return Card(Red, 0);
+    }
+    return Card(static_cast<Color>(index / 7), index % 7 + 1);
+}
+
+// Разбирает карту в формате Card::toString ("Blue 5"); допускается запись без пробела ("Blue5")
+inline Card cardFromString(const std::string& text) {
+    size_t split = text.find_first_of("0123456789");
+    if (split == std::string::npos || split == 0) {
+        throw std::runtime_error("Неверная карта: " + text);
+    }
+    std::string name = text.substr(0, split);
+    while (!name.empty() && name.back() == ' ') name.pop_back();
+
+    int color = colorFromName(name);
+    int value = std::stoi(text.substr(split));
+    bool valid = color >= 0 && ((value >= 1 && value <= 7) || (color == Red && value == 0));
+    if (!valid) {
+        throw std::runtime_error("Неверная карта: " + text);
+    }
+    return Card(static_cast<Color>(color), value);
+}
+
+// Бинарный вектор из 50 битов: 49 обычных карт + красная 0
+inline std::string cardsToBinaryArray(const std::vector<Card>& cards) {
+    std::array<int, 50> presence = {0};
+    for (const auto& c : cards) {
+        presence[getCardIndex(c)] = 1;
+    }
+    std::string result;
+    for (int i = 0; i < 50; ++i) {
+        result += presence[i] ? '1' : '0';
+    }
+    return result;
+}
+
+inline std::string ruleCardToBinary(const Card& ruleCard) {
+    std::array<int, 50> presence = {0};
+    presence[getCardIndex(ruleCard)] = 1;
+    std::string result;
+    for (int i = 0; i < 50; ++i) {
+        result += presence[i] ? '1' : '0';
+    }
+    return result;
+}
+
+inline std::string otherPalettesToBinary(const std::vector<std::vector<Card>>& palettes, int currentPlayer, const std::vector<bool>& active) {
+    std::array<int, 50> presence = {0};
+    for (int i = 0; i < (int)palettes.size(); ++i) {
+        if (i != currentPlayer && active[i]) {
+            for (const auto& c : palettes[i]) {
+                presence[getCardIndex(c)] = 1;
+            }
+        }
+    }
+    std::string result;
+    for (int i = 0; i < 50; ++i) {
+        result += presence[i] ? '1' : '0';
+    }
+    return result;
+}
+
+inline std::string deckCardsToBinary(const std::vector<std::vector<Card>>& hands, const std::vector<std::vector<Card>>& palettes, const std::vector<bool>& active) {
+    std::array<int, 50> presence = {0};
+
+    // Изначально все обычные карты в колоде (0–48), красная 0 (49) не входит
+    for (int i = 0; i < 49; ++i) {
+        presence[i] = 1;
+    }
+
+    for (int i = 0; i < (int)hands.size(); ++i) {
+        if (active[i]) {
+            for (const auto& c : hands[i]) {
+                presence[getCardIndex(c)] = 0;
+            }
+            for (const auto& c : palettes[i]) {
+                presence[getCardIndex(c)] = 0;
+            }
+        }
+    }
+
+    std::string result;
+    for (int i = 0; i < 50; ++i) {
+        result += presence[i] ? '1' : '0';
+    }
+    return result;
+}
+
+// Та же раскладка битов, что и в строках выше, но в виде маски: бит i = карта с индексом i
+const uint64_t kDeckMask = (1ULL << 49) - 1;  // все обычные карты (0–48)
+
+inline uint64_t cardsToMask(const std::vector<Card>& cards) {
+    uint64_t mask = 0;
+    for (const auto& c : cards) {
+        mask |= 1ULL << getCardIndex(c);
+    }
+    return mask;
+}
+
+inline std::vector<Card> cardsFromMask(uint64_t mask) {
+    std::vector<Card> cards;
+    while (mask) {
+        int index = __builtin_ctzll(mask);
+        cards.push_back(cardFromIndex(index));
+        mask &= mask - 1;
+    }
+    return cards;
+}
+
+inline std::string maskToBinary(uint64_t mask) {
+    std::string result(50, '0');
+    for (int i = 0; i < 50; ++i) {
+        if (mask >> i & 1) result[i] = '1';
+    }
+    return result;
+}
+
+#endif // GAME_7_RED_RULES_H
@@ -0,0 +1,206 @@
+/*
+    Red7 Rule Score Cache
+
+    Описание(ru):
+    Оценка палитры по каждому из 7 правил зависит только от множества карт палитры,
+    поэтому для палитр до заданного размера её можно посчитать один раз заранее.
+    Таблица (правило, маска палитры) → оценка строится программой score_cache_generator_for_game_7_Red.cpp,
+    а этот заголовок открывает её через mmap только для чтения и подключает к getWinningMoves:
+    вместо вызова comparison_* выполняется один поиск в таблице. Палитры больше maxPaletteSize
+    по-прежнему оцениваются через comparison_*, поэтому память ограничена размером таблицы.
+
+    Основные компоненты:
+    - scoreCacheEntries: число палитр из 0..maxPaletteSize карт (сочетания из 49 карт колоды).
+    - scoreCacheChecksum: контрольная сумма таблицы оценок (FNV-1a по 64-битным словам).
+    - RuleScoreCache::index / score: номер палитры в таблице и оценка (computeRuleScore из game_7_Red_rules.h).
+    - RuleScoreCache::install: подключает таблицу к ruleScoreForMask (getWinningMoves / getWinningMovesForMasks) текущего процесса.
+
+    Формат файла (little-endian):
+        char[4]  magic = "R7SC"
+        uint32   version = 1
+        uint32   maxPaletteSize   — максимум карт в палитре, хранящейся в таблице
+        uint32   reserved
+        uint64   entriesPerRule   — scoreCacheEntries(maxPaletteSize)
+        uint64   checksum         — scoreCacheChecksum по массиву оценок
+        uint16   scores[7][entriesPerRule]   (дополнено до 8 байт)
+    Палитры одного размера k лежат подряд в колексикографическом порядке масок:
+    номер палитры = сумма по её картам C(индекс карты, порядковый номер карты в палитре, начиная с 1)
+    плюс число палитр меньшего размера.
+*/
+
+/*
+    Red7 Rule Score Cache
+
+    Description(eng):
+    The score of a palette under each of the 7 rules depends only on the set of cards in the palette,
+    so for palettes up to a given size it can be computed once in advance.
+    The (rule, palette mask) → score table is built by score_cache_generator_for_game_7_Red.cpp,
+    and this header opens it through a read-only mmap and plugs it into getWinningMoves:
+    instead of calling comparison_*, a single table lookup is made. Palettes larger than maxPaletteSize
+    are still scored through comparison_*, so memory is bounded by the table size.
+
+    Main components:
+    - scoreCacheEntries: the number of palettes of 0..maxPaletteSize cards (combinations of the 49 deck cards).
+    - scoreCacheChecksum: the checksum of the score table (FNV-1a over 64-bit words).
+    - RuleScoreCache::index / score: the palette's position in the table and its score (computeRuleScore from game_7_Red_rules.h).
+    - RuleScoreCache::install: plugs the table into ruleScoreForMask (getWinningMoves / getWinningMovesForMasks) of the current process.
+
+    File format (little-endian):
+        char[4]  magic = "R7SC"
+        uint32   version = 1
+        uint32   maxPaletteSize   — maximum number of cards in a palette stored in the table
+        uint32   reserved
+        uint64   entriesPerRule   — scoreCacheEntries(maxPaletteSize)
+        uint64   checksum         — scoreCacheChecksum over the score array
+        uint16   scores[7][entriesPerRule]   (padded to 8 bytes)
+    Palettes of the same size k are stored contiguously in colexicographic order of their masks:
+    palette number = sum over its cards of C(card index, position of the card in the palette starting from 1)
+    plus the number of smaller palettes.
+*/
+
+#ifndef GAME_7_RED_SCORE_CACHE_H
+#define GAME_7_RED_SCORE_CACHE_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "game_7_Red_mapped_file.h"
+#include "game_7_Red_rules.h"
+
+const int kScoreCacheCards = 49;          // карты колоды, красная 0 в палитру не попадает
+// Предел размера таблицы (8 карт — уже около 7 ГБ), а не палитры: с --discard-to-draw палитра
+// может быть больше, такие палитры оцениваются через comparison_*
+const int kScoreCacheMaxPaletteSize = 8;
+const int kScoreCacheRules = 7;
+
+struct ScoreCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t maxPaletteSize;
+    uint32_t reserved;
+    uint64_t entriesPerRule;
+    uint64_t checksum;
+};
+
+// Биномиальные коэффициенты C(n, k) для n <= 49, k <= kScoreCacheMaxPaletteSize
+struct ScoreCacheBinomials {
+    uint64_t values[kScoreCacheCards + 1][kScoreCacheMaxPaletteSize + 1] = {};
+
+    ScoreCacheBinomials() {
+        for (int n = 0; n <= kScoreCacheCards; ++n) {
+            values[n][0] = 1;
+            for (int k = 1; k <= kScoreCacheMaxPaletteSize && k <= n; ++k) {
+                values[n][k] = values[n - 1][k - 1] + values[n - 1][k];
+            }
+        }
+    }
+};
+
+inline const ScoreCacheBinomials& scoreCacheBinomials() {
+    static const ScoreCacheBinomials binomials;
+    return binomials;
+}
+
+// Число палитр размера меньше size; при size = maxPaletteSize + 1 — размер таблицы одного правила
+inline uint64_t scoreCacheOffset(int size) {
+    uint64_t offset = 0;
+    for (int k = 0; k < size; ++k) offset += scoreCacheBinomials().values[kScoreCacheCards][k];
+    return offset;
+}
+
+inline uint64_t scoreCacheEntries(int maxPaletteSize) {
+    return scoreCacheOffset(maxPaletteSize + 1);
+}
+
+inline uint64_t scoreCacheChecksum(const uint16_t* scores, uint64_t count) {
+    const char* bytes = reinterpret_cast<const char*>(scores);
+    uint64_t size = count * sizeof(uint16_t);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t offset = 0;
+    for (; offset + 8 <= size; offset += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + offset, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    for (; offset < size; ++offset) {
+        hash = (hash ^ (uint8_t)bytes[offset]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+class RuleScoreCache {
+public:
+    explicit RuleScoreCache(const std::string& path) : file(path, sizeof(ScoreCacheHeader)) {
+        std::memcpy(&header, file.bytes(), sizeof(header));
+        scores = reinterpret_cast<const uint16_t*>(file.bytes() + sizeof(header));
+
+        bool valid = std::memcmp(header.magic, "R7SC", 4) == 0 && header.version == 1 &&
+                     header.maxPaletteSize <= (uint32_t)kScoreCacheMaxPaletteSize &&
+                     header.entriesPerRule == scoreCacheEntries(header.maxPaletteSize) &&
+                     file.size() >= sizeof(header) + kScoreCacheRules * header.entriesPerRule * sizeof(uint16_t);
+        if (!valid) {
+            throw std::runtime_error("Неверный формат таблицы оценок " + path);
+        }
+        if (scoreCacheChecksum(scores, kScoreCacheRules * header.entriesPerRule) != header.checksum) {
+            throw std::runtime_error("Контрольная сумма таблицы оценок " + path + " не совпадает");
+        }
+
+        for (int k = 0; k <= kScoreCacheMaxPaletteSize + 1; ++k) {
+            offsets[k] = scoreCacheOffset(k);
+        }
+    }
+
+    ~RuleScoreCache() {
+        if (activeCache() == this) {
+            ruleScoreLookup() = nullptr;
+            activeCache() = nullptr;
+        }
+    }
+
+    RuleScoreCache(const RuleScoreCache&) = delete;
+    RuleScoreCache& operator=(const RuleScoreCache&) = delete;
+
+    int maxPaletteSize() const { return (int)header.maxPaletteSize; }
+    uint64_t entriesPerRule() const { return header.entriesPerRule; }
+    bool contains(uint64_t paletteMask) const {
+        return (paletteMask & ~kDeckMask) == 0 && __builtin_popcountll(paletteMask) <= (int)header.maxPaletteSize;
+    }
+
+    // Номер палитры среди палитр той же таблицы; маска должна проходить contains
+    uint64_t index(uint64_t paletteMask) const {
+        const auto& binomials = scoreCacheBinomials().values;
+        uint64_t result = offsets[__builtin_popcountll(paletteMask)];
+        for (int k = 1; paletteMask; ++k) {
+            result += binomials[__builtin_ctzll(paletteMask)][k];
+            paletteMask &= paletteMask - 1;
+        }
+        return result;
+    }
+
+    // Оценка computeRuleScore или -1, если палитры нет в таблице
+    int score(Color rule, uint64_t paletteMask) const {
+        if (!contains(paletteMask)) return -1;
+        return scores[(uint64_t)rule * header.entriesPerRule + index(paletteMask)];
+    }
+
+    // Подключает таблицу к ruleScoreForMask; объект должен жить, пока идут вызовы getWinningMoves
+    void install() const {
+        activeCache() = this;
+        ruleScoreLookup() = [](Color rule, uint64_t paletteMask) { return activeCache()->score(rule, paletteMask); };
+    }
+
+private:
+    static const RuleScoreCache*& activeCache() {
+        static const RuleScoreCache* cache = nullptr;
+        return cache;
+    }
+
+    MappedFile file;
+    ScoreCacheHeader header;
+    const uint16_t* scores = nullptr;
+    uint64_t offsets[kScoreCacheMaxPaletteSize + 2] = {};
+};
+
+#endif // GAME_7_RED_SCORE_CACHE_H
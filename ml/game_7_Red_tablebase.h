@@ -0,0 +1,300 @@
+/*
+    Red7 Endgame Tablebase
+
+    Описание(ru):
+    Таблица эндшпилей для игры Red7 на двоих: для позиций с небольшим числом карт в руках
+    хранится точный результат (победа или поражение игрока, который ходит).
+    Таблица строится программой tablebase_generator_for_game_7_Red.cpp,
+    а этот заголовок даёт API запроса через mmap только для чтения — один поиск на позицию.
+
+    Палитры в Red7 растут без ограничений, поэтому перечислить все позиции даже с малым числом карт
+    в руках невозможно: файл содержит только позиции, достижимые из корней. Если корни взяты из партий
+    размечаемого файла (--roots-from), таблица отвечает на все их позиции в пределах бюджета;
+    с корнями из случайных партий на позициях из новых партий она почти всегда даёт промах.
+    Поэтому основной API — EndgameSolver: он сначала обращается к таблице, а при промахе решает позицию
+    перебором (замыкание эндшпиля из нескольких десятков позиций решается за доли миллисекунды)
+    и запоминает результаты.
+
+    Основные компоненты:
+    - TablebasePosition: позиция в виде масок (правило, рука и палитра ходящего, рука и палитра соперника).
+    - tablebaseSuccessors: все позиции после выигрышных ходов (getWinningMoves), ход переходит к сопернику.
+    - positionKey / tablebaseBucket / tablebaseSlot: хеши позиции и совершенное хеширование
+        (схема "hash and displace": у каждой корзины свой pilot, подобранный без коллизий).
+    - EndgameTablebase::probe: Win / Loss / Unknown (позиции нет в таблице или карт больше бюджета).
+    - EndgameSolver::solve: точный Win / Loss для любой позиции в пределах бюджета решателя
+        (Unknown — только если карт в руках больше бюджета).
+
+    Формат файла (little-endian):
+        char[4]  magic = "R7TB"
+        uint32   version = 2
+        uint32   cardBudget     — максимум карт в обеих руках вместе
+        uint32   reserved
+        uint64   keyCount, slotCount, bucketCount, hashSeed
+        uint16   pilots[bucketCount]         (дополнено до 8 байт)
+        uint64   keys[slotCount]             — ключ позиции в слоте (64-битный хеш positionKey)
+        uint64   usedBits[(slotCount + 63) / 64]     — 1 = слот занят
+        uint64   resultBits[(slotCount + 63) / 64]   — 1 = ходящий выигрывает
+    Отсутствующая позиция определяется по пустому слоту или несовпадению ключа. Позиция занимает около 200 бит,
+    а ключ — 64-битный хеш, поэтому отсутствующая позиция с тем же хешем, что и позиция в слоте,
+    ошибочно получит её результат; вероятность этого для одного запроса около 2^-64.
+*/
+
+/*
+    Red7 Endgame Tablebase
+
+    Description(eng):
+    An endgame tablebase for two-player Red7: for positions with few cards left in hand
+    it stores the exact result (a win or a loss for the player to move).
+    The table is built by tablebase_generator_for_game_7_Red.cpp,
+    and this header provides the probe API over a read-only mmap — one lookup per position.
+
+    Palettes in Red7 grow without bound, so enumerating every position even with few cards in hand
+    is impossible: the file only holds the positions reachable from its roots. When the roots come from
+    the games of the file being labeled (--roots-from), the table answers every one of their positions within
+    the budget; with roots from random games it almost always misses on positions from new games.
+    The main API is therefore EndgameSolver: it consults the table first and, on a miss, solves the position
+    by search (an endgame closure of a few dozen positions is solved in a fraction of a millisecond)
+    and remembers the results.
+
+    Main components:
+    - TablebasePosition: a position as masks (rule, mover's hand and palette, opponent's hand and palette).
+    - tablebaseSuccessors: all positions after the winning moves (getWinningMoves); the turn passes to the opponent.
+    - positionKey / tablebaseBucket / tablebaseSlot: position hashes and perfect hashing
+        ("hash and displace": each bucket has its own pilot chosen so that there are no collisions).
+    - EndgameTablebase::probe: Win / Loss / Unknown (the position is not in the table or exceeds the card budget).
+    - EndgameSolver::solve: an exact Win / Loss for any position within the solver's budget
+        (Unknown only when the hands hold more cards than the budget).
+
+    File format (little-endian):
+        char[4]  magic = "R7TB"
+        uint32   version = 2
+        uint32   cardBudget     — maximum number of cards in both hands together
+        uint32   reserved
+        uint64   keyCount, slotCount, bucketCount, hashSeed
+        uint16   pilots[bucketCount]         (padded to 8 bytes)
+        uint64   keys[slotCount]             — the key of the position in the slot (the 64-bit positionKey hash)
+        uint64   usedBits[(slotCount + 63) / 64]     — 1 = the slot is occupied
+        uint64   resultBits[(slotCount + 63) / 64]   — 1 = the player to move wins
+    A missing position is detected by an empty slot or a mismatching key. A position takes about 200 bits
+    while the key is a 64-bit hash, so a missing position with the same hash as the position in the slot
+    would wrongly get its result; the probability of that is about 2^-64 per probe.
+*/
+
+#ifndef GAME_7_RED_TABLEBASE_H
+#define GAME_7_RED_TABLEBASE_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "game_7_Red_mapped_file.h"
+#include "game_7_Red_rules.h"
+
+struct TablebasePosition {
+    uint64_t hand = 0;
+    uint64_t palette = 0;
+    uint64_t opponentHand = 0;
+    uint64_t opponentPalette = 0;
+    int rule = 49;  // индекс карты-правила, по умолчанию красная 0
+
+    int handCards() const { return __builtin_popcountll(hand) + __builtin_popcountll(opponentHand); }
+
+    bool operator==(const TablebasePosition& other) const {
+        return hand == other.hand && palette == other.palette && opponentHand == other.opponentHand &&
+               opponentPalette == other.opponentPalette && rule == other.rule;
+    }
+};
+
+enum TablebaseResult {
+    Unknown = 0,
+    Loss = 1,
+    Win = 2
+};
+
+struct TablebaseHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t cardBudget;
+    uint32_t reserved;
+    uint64_t keyCount;
+    uint64_t slotCount;
+    uint64_t bucketCount;
+    uint64_t hashSeed;
+};
+
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// 64-битный хеш позиции (не сама позиция): разные позиции совпадают с вероятностью около 2^-64
+inline uint64_t positionKey(const TablebasePosition& p, uint64_t seed) {
+    uint64_t h = mixHash(seed ^ (uint64_t)p.rule);
+    h = mixHash(h ^ p.hand);
+    h = mixHash(h ^ p.palette);
+    h = mixHash(h ^ p.opponentHand);
+    h = mixHash(h ^ p.opponentPalette);
+    return h;
+}
+
+struct TablebasePositionHasher {
+    size_t operator()(const TablebasePosition& p) const { return positionKey(p, 0); }
+};
+
+inline uint64_t tablebaseBucket(uint64_t key, uint64_t bucketCount) {
+    return key % bucketCount;
+}
+
+inline uint64_t tablebaseSlot(uint64_t key, uint16_t pilot, uint64_t slotCount) {
+    return mixHash(key ^ ((uint64_t)pilot * 0x9e3779b97f4a7c15ULL)) % slotCount;
+}
+
+// Позиции после каждого выигрышного хода; пустой результат — ходящий выбывает и проигрывает
+inline std::vector<TablebasePosition> tablebaseSuccessors(const TablebasePosition& p) {
+    std::vector<std::vector<Card>> otherPalettes = {cardsFromMask(p.opponentPalette)};
+    auto moves = getWinningMoves(cardFromIndex(p.rule), cardsFromMask(p.hand), cardsFromMask(p.palette), otherPalettes);
+
+    std::vector<TablebasePosition> successors;
+    successors.reserve(moves.size());
+    for (const auto& [newRuleCard, newHand, newPalette] : moves) {
+        TablebasePosition next;
+        next.hand = p.opponentHand;
+        next.palette = p.opponentPalette;
+        next.opponentHand = cardsToMask(newHand);
+        next.opponentPalette = cardsToMask(newPalette);
+        next.rule = getCardIndex(newRuleCard);
+        successors.push_back(next);
+    }
+    return successors;
+}
+
+class EndgameTablebase {
+public:
+    explicit EndgameTablebase(const std::string& path) : file(path, sizeof(TablebaseHeader)) {
+        std::memcpy(&header, file.bytes(), sizeof(header));
+        const uint8_t* base = file.bytes();
+        size_t offset = sizeof(header);
+        pilots = reinterpret_cast<const uint16_t*>(base + offset);
+        offset += paddedBytes(header.bucketCount * sizeof(uint16_t));
+        keys = reinterpret_cast<const uint64_t*>(base + offset);
+        offset += header.slotCount * sizeof(uint64_t);
+        used = reinterpret_cast<const uint64_t*>(base + offset);
+        offset += (header.slotCount + 63) / 64 * sizeof(uint64_t);
+        results = reinterpret_cast<const uint64_t*>(base + offset);
+        offset += (header.slotCount + 63) / 64 * sizeof(uint64_t);
+
+        if (std::memcmp(header.magic, "R7TB", 4) != 0 || header.version != 2 ||
+            header.bucketCount == 0 || header.slotCount == 0 || file.size() < offset) {
+            throw std::runtime_error("Неверный формат таблицы эндшпилей " + path);
+        }
+    }
+
+    EndgameTablebase(const EndgameTablebase&) = delete;
+    EndgameTablebase& operator=(const EndgameTablebase&) = delete;
+
+    static size_t paddedBytes(size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+    int cardBudget() const { return (int)header.cardBudget; }
+    uint64_t positions() const { return header.keyCount; }
+
+    TablebaseResult probe(const TablebasePosition& p) const {
+        if (p.handCards() > (int)header.cardBudget) return Unknown;
+
+        uint64_t key = positionKey(p, header.hashSeed);
+        uint16_t pilot = pilots[tablebaseBucket(key, header.bucketCount)];
+        uint64_t slot = tablebaseSlot(key, pilot, header.slotCount);
+        if (!(used[slot / 64] >> (slot % 64) & 1) || keys[slot] != key) return Unknown;
+        return (results[slot / 64] >> (slot % 64) & 1) ? Win : Loss;
+    }
+
+    TablebaseResult probe(const Card& ruleCard, const std::vector<Card>& hand, const std::vector<Card>& palette,
+                          const std::vector<Card>& opponentHand, const std::vector<Card>& opponentPalette) const {
+        TablebasePosition p;
+        p.rule = getCardIndex(ruleCard);
+        p.hand = cardsToMask(hand);
+        p.palette = cardsToMask(palette);
+        p.opponentHand = cardsToMask(opponentHand);
+        p.opponentPalette = cardsToMask(opponentPalette);
+        return probe(p);
+    }
+
+private:
+    MappedFile file;
+    TablebaseHeader header;
+    const uint16_t* pilots = nullptr;
+    const uint64_t* keys = nullptr;
+    const uint64_t* used = nullptr;
+    const uint64_t* results = nullptr;
+};
+
+const int kEndgameSolverBudget = 8;
+
+// Решатель эндшпилей: сначала таблица (если задана), при промахе — перебор с запоминанием.
+// Каждый ход уменьшает руку ходящего, поэтому глубина рекурсии не больше числа карт в руках.
+// Позиция выигрышна, если есть ход в позицию, проигрышную для соперника; без ходов ходящий выбывает.
+class EndgameSolver {
+public:
+    explicit EndgameSolver(int cardBudget = kEndgameSolverBudget, const EndgameTablebase* tablebase = nullptr)
+        : budget(cardBudget), table(tablebase) {}
+
+    TablebaseResult solve(const TablebasePosition& p) {
+        if (p.handCards() > budget) return Unknown;
+        return solveWin(p) ? Win : Loss;
+    }
+
+    TablebaseResult solve(const Card& ruleCard, const std::vector<Card>& hand, const std::vector<Card>& palette,
+                          const std::vector<Card>& opponentHand, const std::vector<Card>& opponentPalette) {
+        TablebasePosition p;
+        p.rule = getCardIndex(ruleCard);
+        p.hand = cardsToMask(hand);
+        p.palette = cardsToMask(palette);
+        p.opponentHand = cardsToMask(opponentHand);
+        p.opponentPalette = cardsToMask(opponentPalette);
+        return solve(p);
+    }
+
+    int cardBudget() const { return budget; }
+
+    // Все решённые перебором позиции; их можно записать в файл таблицы
+    const std::unordered_map<TablebasePosition, bool, TablebasePositionHasher>& solved() const { return memo; }
+    uint64_t tableHits() const { return hits; }
+
+    void clear() { memo.clear(); }
+
+private:
+    bool solveWin(const TablebasePosition& p) {
+        if (table) {
+            TablebaseResult stored = table->probe(p);
+            if (stored != Unknown) {
+                ++hits;
+                return stored == Win;
+            }
+        }
+        auto it = memo.find(p);
+        if (it != memo.end()) return it->second;
+
+        bool win = false;
+        for (const auto& next : tablebaseSuccessors(p)) {
+            if (!solveWin(next)) {
+                win = true;
+                break;
+            }
+        }
+        memo.emplace(p, win);
+        return win;
+    }
+
+    int budget;
+    const EndgameTablebase* table;
+    std::unordered_map<TablebasePosition, bool, TablebasePositionHasher> memo;
+    uint64_t hits = 0;
+};
+
+#endif // GAME_7_RED_TABLEBASE_H
@@ -0,0 +1,143 @@
+/*
+    Red7 Replay Tool
+
+    Описание(ru):
+    Этот файл реализует работу с компактным файлом партий (game_7_Red_replay.h), который пишет
+    data_generator_for_game_7_Red.cpp в режиме --replay. Строки датасета восстанавливаются
+    повторным проигрыванием записанных ходов — параллельно по партиям, в исходном порядке.
+
+    Команды:
+    - expand <games.r7rp> [dataset.txt] [--threads N] — восстановить строки в формате dataset.txt.
+    - stats <games.r7rp>                              — размер файла в байтах на партию и на ход
+                                                        в сравнении с текстовым форматом.
+*/
+
+/*
+    Red7 Replay Tool
+
+    Description(eng):
+    This file implements the tooling for the compact games file (game_7_Red_replay.h) written by
+    data_generator_for_game_7_Red.cpp in --replay mode. Dataset lines are restored by replaying
+    the recorded moves, in parallel across games and in the original order.
+
+    Commands:
+    - expand <games.r7rp> [dataset.txt] [--threads N] — restore the lines in the dataset.txt format.
+    - stats <games.r7rp>                              — file size in bytes per game and per move
+                                                        compared with the text format.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+#include "game_7_Red_replay.h"
+using namespace std;
+
+const size_t kGamesPerTask = 256;
+
+int expandReplay(const string& inputPath, const string& outputPath, unsigned threads) {
+    ReplayReader reader(inputPath);
+    ofstream out(outputPath);
+    if (!out.is_open()) {
+        cerr << "Не удалось открыть " << outputPath << " для записи\n";
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    const size_t games = reader.games();
+    const size_t tasksPerBatch = threads * 4;
+    vector<string> chunks(tasksPerBatch);
+    long long rows = 0;
+
+    // Пакет задач восстанавливается параллельно, затем куски пишутся по порядку
+    for (size_t batchStart = 0; batchStart < games; batchStart += tasksPerBatch * kGamesPerTask) {
+        atomic<size_t> nextTask(0);
+        atomic<long long> batchRows(0);
+        string error;
+        mutex errorMutex;
+
+        auto worker = [&]() {
+            for (size_t t = nextTask++; t < tasksPerBatch; t = nextTask++) {
+                string& chunk = chunks[t];
+                chunk.clear();
+                size_t first = batchStart + t * kGamesPerTask;
+                size_t last = min(games, first + kGamesPerTask);
+                try {
+                    for (size_t g = first; g < last; ++g) {
+                        auto gameRows = reconstructGame(reader.game(g));
+                        for (const auto& row : gameRows) chunk += row.line;
+                        batchRows += gameRows.size();
+                    }
+                } catch (const exception& e) {
+                    lock_guard<mutex> lock(errorMutex);
+                    error = e.what();
+                }
+            }
+        };
+
+        vector<thread> pool;
+        for (unsigned i = 1; i < threads; ++i) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+        if (!error.empty()) {
+            cerr << error << "\n";
+            return 1;
+        }
+
+        for (const auto& chunk : chunks) out << chunk;
+        rows += batchRows;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Восстановлено партий: " << games << ", строк: " << rows << ", время: " << seconds << " с\n";
+    return out ? 0 : 1;
+}
+
+int printStats(const string& inputPath) {
+    ReplayReader reader(inputPath);
+    long long moves = 0, textBytes = 0;
+    for (size_t g = 0; g < reader.games(); ++g) {
+        ReplayGame game = reader.game(g);
+        moves += game.moves.size();
+        for (const auto& row : reconstructGame(game)) textBytes += row.line.size();
+    }
+
+    size_t games = max<size_t>(1, reader.games());
+    cout << "Партий: " << reader.games() << ", ходов: " << moves << "\n";
+    cout << "Размер файла партий: " << reader.bytes() << " байт (" << (double)reader.bytes() / games << " на партию)\n";
+    cout << "Размер в формате dataset.txt: " << textBytes << " байт (" << (double)textBytes / games << " на партию)\n";
+    cout << "Сжатие: " << (double)textBytes / max<uint64_t>(1, reader.bytes()) << "x\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    string command = argc > 1 ? argv[1] : "";
+    try {
+        if (command == "expand" && argc >= 3) {
+            string outputPath = "dataset.txt";
+            unsigned threads = max(1u, thread::hardware_concurrency());
+            for (int i = 3; i < argc; ++i) {
+                string arg = argv[i];
+                if (arg == "--threads" && i + 1 < argc) threads = max(1, stoi(argv[++i]));
+                else outputPath = arg;
+            }
+            return expandReplay(argv[2], outputPath, threads);
+        }
+        if (command == "stats" && argc == 3) {
+            return printStats(argv[2]);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+
+    cerr << "Использование:\n"
+         << "  " << argv[0] << " expand <games.r7rp> [dataset.txt] [--threads N]\n"
+         << "  " << argv[0] << " stats <games.r7rp>\n";
+    return 1;
+}
@@ -0,0 +1,229 @@
+/*
+    Red7 Rule Score Cache Generator
+
+    Описание(ru):
+    Этот файл строит таблицу оценок палитр (game_7_Red_score_cache.h): для каждого из 7 правил
+    и каждой палитры из не более чем maxPaletteSize карт сохраняется computeRuleScore —
+    результат comparison_* одним числом. Палитры одного размера перебираются по возрастанию маски,
+    что совпадает с порядком хранения в таблице; правила считаются параллельно.
+    После записи таблица открывается через mmap (с проверкой контрольной суммы), сравнивается
+    с посчитанными оценками, и измеряется скорость getWinningMoves без таблицы и с ней на позициях
+    из случайных партий — отдельно для позиций, целиком покрытых таблицей, и для позиций
+    с палитрами больше maxPaletteSize, которые оцениваются через comparison_*.
+
+    Использование:
+    - ./score_cache_generator <scores.r7sc> [--max-size N] [--threads N]
+      --max-size — максимум карт в палитре (по умолчанию 5; 5 карт — около 30 МБ, 6 карт — около 220 МБ).
+*/
+
+/*
+    Red7 Rule Score Cache Generator
+
+    Description(eng):
+    This file builds the palette score table (game_7_Red_score_cache.h): for each of the 7 rules
+    and each palette of at most maxPaletteSize cards it stores computeRuleScore —
+    the comparison_* result as a single number. Palettes of the same size are enumerated in increasing
+    mask order, which matches the storage order in the table; the rules are computed in parallel.
+    After writing, the table is opened through mmap (with checksum verification), compared
+    against the computed scores, and the speed of getWinningMoves is measured without and with the table
+    on positions from random games — separately for positions fully covered by the table and for positions
+    with palettes larger than maxPaletteSize, which fall back to comparison_*.
+
+    Usage:
+    - ./score_cache_generator <scores.r7sc> [--max-size N] [--threads N]
+      --max-size — maximum number of cards in a palette (5 by default; 5 cards take about 30 MB, 6 cards about 220 MB).
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+
+#include "game_7_Red_score_cache.h"
+using namespace std;
+
+// Следующая маска с тем же числом единиц (по возрастанию)
+uint64_t nextSameSizeMask(uint64_t mask) {
+    uint64_t lowest = mask & (~mask + 1);
+    uint64_t ripple = mask + lowest;
+    return ripple | (((mask ^ ripple) >> 2) / lowest);
+}
+
+void fillRuleScores(Color rule, int maxPaletteSize, uint16_t* scores) {
+    uint64_t entry = 0;
+    scores[entry++] = (uint16_t)computeRuleScore(rule, {});
+    for (int size = 1; size <= maxPaletteSize; ++size) {
+        uint64_t last = ((1ULL << size) - 1) << (kScoreCacheCards - size);
+        for (uint64_t mask = (1ULL << size) - 1;; mask = nextSameSizeMask(mask)) {
+            scores[entry++] = (uint16_t)computeRuleScore(rule, cardsFromMask(mask));
+            if (mask == last) break;
+        }
+    }
+}
+
+int writeScoreCache(const string& path, int maxPaletteSize, const vector<uint16_t>& scores) {
+    ScoreCacheHeader header;
+    memcpy(header.magic, "R7SC", 4);
+    header.version = 1;
+    header.maxPaletteSize = maxPaletteSize;
+    header.reserved = 0;
+    header.entriesPerRule = scoreCacheEntries(maxPaletteSize);
+    header.checksum = scoreCacheChecksum(scores.data(), scores.size());
+
+    ofstream out(path, ios::binary);
+    if (!out.is_open()) {
+        cerr << "Не удалось открыть " << path << " для записи\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t bytes = scores.size() * sizeof(uint16_t);
+    out.write(reinterpret_cast<const char*>(scores.data()), bytes);
+    static const char zeros[8] = {0};
+    out.write(zeros, (bytes + 7) / 8 * 8 - bytes);
+    return out ? 0 : 1;
+}
+
+struct BenchmarkPosition {
+    Card rule;
+    vector<Card> hand;
+    vector<Card> palette;
+    vector<vector<Card>> otherPalettes;
+};
+
+// Позиции из случайных партий на двоих, как в data_generator_for_game_7_Red.cpp: размеры палитр
+// имеют то же распределение, что и при генерации датасета
+vector<BenchmarkPosition> makeBenchmarkPositions(int count, mt19937& rng) {
+    vector<BenchmarkPosition> positions;
+    while ((int)positions.size() < count) {
+        vector<Card> deck = createFullDeck();
+        shuffle(deck.begin(), deck.end(), rng);
+
+        vector<vector<Card>> hands = {vector<Card>(deck.begin(), deck.begin() + 7), vector<Card>(deck.begin() + 7, deck.begin() + 14)};
+        vector<vector<Card>> palettes(2);
+        Card rule(Red, 0);
+        for (int turn = 0; (int)positions.size() < count; turn ^= 1) {
+            positions.push_back({rule, hands[turn], palettes[turn], {palettes[turn ^ 1]}});
+            auto moves = getWinningMoves(rule, hands[turn], palettes[turn], {palettes[turn ^ 1]});
+            if (moves.empty()) break;
+            uniform_int_distribution<int> dist(0, (int)moves.size() - 1);
+            tie(rule, hands[turn], palettes[turn]) = moves[dist(rng)];
+        }
+    }
+    return positions;
+}
+
+// Все оценки позиции берутся из таблицы: палитра после хода и палитра соперника не больше maxPaletteSize
+bool fitsTable(const BenchmarkPosition& p, int maxPaletteSize) {
+    return (int)p.palette.size() + 1 <= maxPaletteSize && (int)p.otherPalettes[0].size() <= maxPaletteSize;
+}
+
+double benchmarkWinningMoves(const vector<BenchmarkPosition>& positions, long long& moves) {
+    auto start = chrono::steady_clock::now();
+    moves = 0;
+    for (const auto& p : positions) {
+        moves += getWinningMoves(p.rule, p.hand, p.palette, p.otherPalettes).size();
+    }
+    return positions.empty() ? 0 : chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / positions.size();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Использование: " << argv[0] << " <scores.r7sc> [--max-size N] [--threads N]\n";
+        return 1;
+    }
+
+    string path = argv[1];
+    int maxPaletteSize = 5;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--max-size") maxPaletteSize = stoi(argv[i + 1]);
+        else if (arg == "--threads") threads = max(1, stoi(argv[i + 1]));
+        else {
+            cerr << "Неизвестный аргумент " << arg << "\n";
+            return 1;
+        }
+    }
+    if (maxPaletteSize < 1 || maxPaletteSize > kScoreCacheMaxPaletteSize) {
+        cerr << "Размер палитры должен быть от 1 до " << kScoreCacheMaxPaletteSize << "\n";
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    const uint64_t entries = scoreCacheEntries(maxPaletteSize);
+    cout << "Палитр на правило: " << entries << ", размер таблицы: "
+         << kScoreCacheRules * entries * sizeof(uint16_t) / (1024.0 * 1024.0) << " МБ\n";
+
+    vector<uint16_t> scores(kScoreCacheRules * entries);
+    atomic<int> nextRule(0);
+    auto worker = [&]() {
+        for (int rule = nextRule++; rule < kScoreCacheRules; rule = nextRule++) {
+            fillRuleScores(static_cast<Color>(rule), maxPaletteSize, scores.data() + rule * entries);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned i = 1; i < min<unsigned>(threads, kScoreCacheRules); ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    cout << "Оценки посчитаны за " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " с\n";
+
+    if (writeScoreCache(path, maxPaletteSize, scores) != 0) {
+        return 1;
+    }
+
+    auto loadStart = chrono::steady_clock::now();
+    RuleScoreCache cache(path);
+    cout << "Загрузка таблицы с проверкой контрольной суммы: "
+         << chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count() << " мс\n";
+
+    // проверка: номер палитры в таблице и сохранённая оценка совпадают с посчитанными
+    size_t mismatches = 0;
+    for (int rule = 0; rule < kScoreCacheRules; ++rule) {
+        uint64_t entry = 1;
+        for (int size = 1; size <= maxPaletteSize; ++size) {
+            uint64_t last = ((1ULL << size) - 1) << (kScoreCacheCards - size);
+            for (uint64_t mask = (1ULL << size) - 1;; mask = nextSameSizeMask(mask)) {
+                if (cache.index(mask) != entry ||
+                    cache.score(static_cast<Color>(rule), mask) != scores[rule * entries + entry]) ++mismatches;
+                ++entry;
+                if (mask == last) break;
+            }
+        }
+    }
+    cout << "Проверка таблицы: " << (mismatches == 0 ? "все оценки совпадают" : to_string(mismatches) + " несовпадений") << "\n";
+
+    // замер на позициях из случайных партий: отдельно те, что целиком помещаются в таблицу,
+    // и те, где часть палитр больше maxPaletteSize и оценивается через comparison_*
+    mt19937 rng(12345);
+    vector<BenchmarkPosition> inTable, fallback;
+    for (auto& p : makeBenchmarkPositions(100000, rng)) {
+        (fitsTable(p, maxPaletteSize) ? inTable : fallback).push_back(std::move(p));
+    }
+
+    const char* names[] = {"палитры в таблице", "часть палитр больше таблицы"};
+    const vector<BenchmarkPosition>* groups[] = {&inTable, &fallback};
+    double withoutCache[2], withCache[2];
+    long long movesWithout[2], movesWith[2];
+    for (int g = 0; g < 2; ++g) withoutCache[g] = benchmarkWinningMoves(*groups[g], movesWithout[g]);
+    cache.install();
+    for (int g = 0; g < 2; ++g) withCache[g] = benchmarkWinningMoves(*groups[g], movesWith[g]);
+
+    bool sameMoves = true;
+    size_t total = inTable.size() + fallback.size();
+    double overallWithout = 0, overallWith = 0;
+    for (int g = 0; g < 2; ++g) {
+        cout << "getWinningMoves (" << names[g] << ", " << 100.0 * groups[g]->size() / total << "% позиций): "
+             << withoutCache[g] << " мкс без таблицы, " << withCache[g] << " мкс с таблицей"
+             << (movesWithout[g] == movesWith[g] ? "" : " — число ходов отличается!") << "\n";
+        sameMoves = sameMoves && movesWithout[g] == movesWith[g];
+        overallWithout += withoutCache[g] * groups[g]->size() / total;
+        overallWith += withCache[g] * groups[g]->size() / total;
+    }
+    cout << "getWinningMoves (все позиции): " << overallWithout << " мкс без таблицы, " << overallWith << " мкс с таблицей\n";
+
+    return mismatches == 0 && sameMoves ? 0 : 1;
+}
@@ -0,0 +1,467 @@
+/*
+    Red7 Endgame Tablebase Generator
+
+    Описание(ru):
+    Этот файл строит таблицу эндшпилей (game_7_Red_tablebase.h) для игры Red7 на двоих.
+    Полный перебор всех палитр невозможен, поэтому корневые позиции берутся из случайных партий
+    (как в data_generator_for_game_7_Red.cpp): как только в обеих руках остаётся не больше
+    cardBudget карт, позиция становится корнем. Затем перечисляются все позиции, достижимые
+    из корней по правилам (getWinningMoves), и решаются ретроградно — слоями по возрастанию
+    числа карт в руках: каждый ход уменьшает руку ходящего, поэтому все последующие позиции
+    уже решены. Позиция выигрышна, если есть ход в позицию, проигрышную для соперника;
+    игрок без выигрышных ходов выбывает и проигрывает.
+
+    Результаты сохраняются в файл с совершенным хешированием (64-битный хеш позиции и 1 бит результата
+    на позицию), после записи таблица открывается через mmap и проверяется запросом каждой позиции.
+    Таблица покрывает только замыкания выбранных корней, поэтому затем на новых случайных партиях
+    измеряется доля попаданий в таблицу и время EndgameSolver на промахах, а результаты решателя
+    сверяются с таблицей там, где она отвечает.
+    С --roots-from корни берутся из файла партий (game_7_Red_replay.h), который предстоит разметить:
+    таблица строится по позициям этих партий и отвечает на каждую их позицию в пределах бюджета.
+
+    Использование:
+    - ./tablebase_generator <tablebase.r7tb> [--budget N] [--games N] [--roots-from games.r7rp] [--seed S] [--check-games N] [--score-cache scores.r7sc]
+      --budget — максимум карт в обеих руках (по умолчанию 6),
+      --games  — число случайных партий для корневых позиций (по умолчанию 10000),
+      --roots-from — файл партий на двоих, из которого берутся корни вместо случайных партий,
+      --check-games — число новых партий для проверки попаданий и решателя (по умолчанию 1000),
+      --score-cache — таблица оценок палитр (game_7_Red_score_cache.h) для ускорения getWinningMoves.
+*/
+
+/*
+    Red7 Endgame Tablebase Generator
+
+    Description(eng):
+    This file builds the endgame tablebase (game_7_Red_tablebase.h) for two-player Red7.
+    A full enumeration of every possible palette is infeasible, so the root positions come from
+    random games (as in data_generator_for_game_7_Red.cpp): as soon as both hands together hold
+    no more than cardBudget cards, the position becomes a root. Then every position reachable
+    from the roots under the rules (getWinningMoves) is enumerated and solved retrogradely,
+    layer by layer in increasing number of cards in hand: every move shrinks the mover's hand,
+    so all the following positions are already solved. A position is a win if there is a move
+    into a position that is lost for the opponent; a player without winning moves is eliminated and loses.
+
+    The results are saved to a file with perfect hashing (a 64-bit position hash and 1 result bit per position).
+    After writing, the table is opened through mmap and checked by probing every position.
+    The table only covers the closures of the sampled roots, so the tool then walks fresh random games,
+    measures the table hit rate and the EndgameSolver time on misses, and checks the solver
+    against the table wherever the table answers.
+    With --roots-from the roots come from the games file (game_7_Red_replay.h) that is going to be labeled:
+    the table is built over the positions of those games and answers every one of them within the budget.
+
+    Usage:
+    - ./tablebase_generator <tablebase.r7tb> [--budget N] [--games N] [--roots-from games.r7rp] [--seed S] [--check-games N] [--score-cache scores.r7sc]
+      --budget — maximum number of cards in both hands (6 by default),
+      --games  — number of random games used for the root positions (10000 by default),
+      --roots-from — a two-player games file whose games provide the roots instead of random games,
+      --check-games — number of fresh games for the hit-rate and solver check (1000 by default),
+      --score-cache — the palette score table (game_7_Red_score_cache.h) that speeds up getWinningMoves.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <memory>
+
+#include "game_7_Red_tablebase.h"
+#include "game_7_Red_score_cache.h"
+#include "game_7_Red_replay.h"
+using namespace std;
+
+// Все позиции, достижимые из корней, и рёбра ходов между ними (в формате CSR)
+struct PositionGraph {
+    vector<TablebasePosition> positions;
+    vector<uint32_t> successorOffsets;
+    vector<uint32_t> successors;
+};
+
+TablebasePosition dealPosition(mt19937& rng) {
+    vector<Card> deck = createFullDeck();
+    shuffle(deck.begin(), deck.end(), rng);
+
+    TablebasePosition p;
+    p.hand = cardsToMask(vector<Card>(deck.begin(), deck.begin() + 7));
+    p.opponentHand = cardsToMask(vector<Card>(deck.begin() + 7, deck.begin() + 14));
+    return p;
+}
+
+vector<TablebasePosition> collectRoots(int numGames, int budget, mt19937& rng) {
+    vector<TablebasePosition> roots;
+
+    for (int game = 0; game < numGames; ++game) {
+        TablebasePosition p = dealPosition(rng);
+
+        // случайная партия до первой позиции в пределах бюджета
+        while (p.handCards() > budget) {
+            auto next = tablebaseSuccessors(p);
+            if (next.empty()) break;
+            uniform_int_distribution<int> dist(0, (int)next.size() - 1);
+            p = next[dist(rng)];
+        }
+        if (p.handCards() <= budget) {
+            roots.push_back(p);
+        }
+    }
+    return roots;
+}
+
+// Маска карты на позиции slot в руке, упорядоченной по индексу карт (как в байте хода)
+uint64_t handSlotMask(uint64_t hand, int slot) {
+    for (; slot > 0 && hand; --slot) hand &= hand - 1;
+    return hand & (~hand + 1);
+}
+
+// Позиции партии из файла партий перед каждым ходом, с точки зрения ходящего.
+// Только партии на двоих; после выбывания игрока позиции на двоих заканчиваются.
+vector<TablebasePosition> replayPositions(const ReplayGame& game) {
+    vector<TablebasePosition> positions;
+    if (game.numPlayers != 2) return positions;
+
+    auto deal = replayDeal(game);
+    uint64_t hands[2] = {cardsToMask(deal[0]), cardsToMask(deal[1])};
+    uint64_t palettes[2] = {0, 0};
+    int rule = 49;
+    for (size_t m = 0; m < game.moves.size(); ++m) {
+        int i = m % 2;
+        TablebasePosition p;
+        p.hand = hands[i];
+        p.palette = palettes[i];
+        p.opponentHand = hands[i ^ 1];
+        p.opponentPalette = palettes[i ^ 1];
+        p.rule = rule;
+        positions.push_back(p);
+
+        uint8_t move = game.moves[m];
+        if (move == kReplayEliminated) break;
+        uint8_t type = move >> 6;
+        uint64_t paletteCard = handSlotMask(hands[i], move >> 3 & 7);
+        uint64_t ruleCard = handSlotMask(hands[i], move & 7);
+        if (type != kReplayToRule) {
+            palettes[i] |= paletteCard;
+            hands[i] &= ~paletteCard;
+        }
+        if (type != kReplayToPalette) {
+            rule = __builtin_ctzll(ruleCard);
+            hands[i] &= ~ruleCard;
+        }
+    }
+    return positions;
+}
+
+// Корни из партий файла, которые предстоит разметить: первая позиция каждой партии в пределах бюджета.
+// Остальные позиции партии достижимы из неё, поэтому таблица отвечает на все позиции этих партий.
+vector<TablebasePosition> collectReplayRoots(const ReplayReader& reader, int budget) {
+    vector<TablebasePosition> roots;
+    size_t skipped = 0;
+    for (size_t g = 0; g < reader.games(); ++g) {
+        ReplayGame game = reader.game(g);
+        if (game.numPlayers != 2) {
+            ++skipped;
+            continue;
+        }
+        for (const auto& p : replayPositions(game)) {
+            if (p.handCards() <= budget) {
+                roots.push_back(p);
+                break;
+            }
+        }
+    }
+    if (skipped > 0) {
+        cout << "Пропущено партий не на двоих: " << skipped << "\n";
+    }
+    return roots;
+}
+
+// Доля позиций партий файла в пределах бюджета, на которые отвечает таблица; возвращает число промахов
+size_t checkReplayGames(const EndgameTablebase& tablebase, const ReplayReader& reader, int budget) {
+    long long positions = 0, hits = 0;
+    for (size_t g = 0; g < reader.games(); ++g) {
+        for (const auto& p : replayPositions(reader.game(g))) {
+            if (p.handCards() > budget) continue;
+            ++positions;
+            if (tablebase.probe(p) != Unknown) ++hits;
+        }
+    }
+    cout << "Партии файла корней: позиций в пределах бюджета " << positions << ", попаданий в таблицу " << hits
+         << " (" << (positions ? 100.0 * hits / positions : 0.0) << "%)\n";
+    return (size_t)(positions - hits);
+}
+
+PositionGraph enumeratePositions(const vector<TablebasePosition>& roots) {
+    PositionGraph graph;
+    unordered_map<TablebasePosition, uint32_t, TablebasePositionHasher> index;
+
+    auto addPosition = [&](const TablebasePosition& p) {
+        auto [it, inserted] = index.emplace(p, (uint32_t)graph.positions.size());
+        if (inserted) graph.positions.push_back(p);
+        return it->second;
+    };
+
+    for (const auto& root : roots) {
+        addPosition(root);
+    }
+
+    // позиции раскрываются в порядке добавления, поэтому CSR заполняется последовательно
+    graph.successorOffsets.push_back(0);
+    for (size_t k = 0; k < graph.positions.size(); ++k) {
+        for (const auto& next : tablebaseSuccessors(graph.positions[k])) {
+            graph.successors.push_back(addPosition(next));
+        }
+        graph.successorOffsets.push_back((uint32_t)graph.successors.size());
+
+        if (k % 100000 == 0 && k > 0) {
+            cout << "Раскрыто позиций: " << k << " из " << graph.positions.size() << "\n";
+        }
+    }
+    return graph;
+}
+
+vector<bool> solvePositions(const PositionGraph& graph) {
+    const size_t n = graph.positions.size();
+    vector<uint32_t> order(n);
+    for (size_t k = 0; k < n; ++k) order[k] = (uint32_t)k;
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return graph.positions[a].handCards() < graph.positions[b].handCards();
+    });
+
+    vector<bool> wins(n, false);
+    for (uint32_t k : order) {
+        for (uint32_t e = graph.successorOffsets[k]; e < graph.successorOffsets[k + 1]; ++e) {
+            if (!wins[graph.successors[e]]) {
+                wins[k] = true;
+                break;
+            }
+        }
+    }
+    return wins;
+}
+
+// Подбирает pilot для каждой корзины (от больших корзин к малым) так, чтобы все ключи попали в разные слоты
+bool buildPerfectHash(const vector<uint64_t>& keys, uint64_t bucketCount, uint64_t slotCount,
+                      vector<uint16_t>& pilots, vector<uint64_t>& slotOfKey) {
+    vector<vector<uint32_t>> buckets(bucketCount);
+    for (size_t k = 0; k < keys.size(); ++k) {
+        buckets[tablebaseBucket(keys[k], bucketCount)].push_back((uint32_t)k);
+    }
+    vector<uint32_t> bucketOrder(bucketCount);
+    for (uint64_t b = 0; b < bucketCount; ++b) bucketOrder[b] = (uint32_t)b;
+    stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    pilots.assign(bucketCount, 0);
+    slotOfKey.assign(keys.size(), 0);
+    vector<bool> taken(slotCount, false);
+    vector<uint64_t> slots;
+
+    for (uint32_t b : bucketOrder) {
+        if (buckets[b].empty()) break;
+
+        bool placed = false;
+        for (uint32_t pilot = 0; pilot <= UINT16_MAX && !placed; ++pilot) {
+            slots.clear();
+            bool ok = true;
+            for (uint32_t k : buckets[b]) {
+                uint64_t slot = tablebaseSlot(keys[k], (uint16_t)pilot, slotCount);
+                if (taken[slot] || find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    ok = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (!ok) continue;
+
+            for (size_t i = 0; i < slots.size(); ++i) {
+                taken[slots[i]] = true;
+                slotOfKey[buckets[b][i]] = slots[i];
+            }
+            pilots[b] = (uint16_t)pilot;
+            placed = true;
+        }
+        if (!placed) return false;
+    }
+    return true;
+}
+
+template <typename T>
+void writePadded(ofstream& out, const vector<T>& values) {
+    size_t bytes = values.size() * sizeof(T);
+    out.write(reinterpret_cast<const char*>(values.data()), bytes);
+    static const char zeros[8] = {0};
+    out.write(zeros, EndgameTablebase::paddedBytes(bytes) - bytes);
+}
+
+int writeTablebase(const string& path, const PositionGraph& graph, const vector<bool>& wins, int budget) {
+    const size_t n = graph.positions.size();
+    TablebaseHeader header;
+    memcpy(header.magic, "R7TB", 4);
+    header.version = 2;
+    header.cardBudget = budget;
+    header.reserved = 0;
+    header.keyCount = n;
+    header.bucketCount = max<uint64_t>(1, n / 4);
+    header.slotCount = max<uint64_t>(1, (uint64_t)(n / 0.97) + 1);
+
+    vector<uint64_t> keys(n);
+    vector<uint16_t> pilots;
+    vector<uint64_t> slotOfKey;
+    bool built = false;
+    for (header.hashSeed = 1; header.hashSeed <= 16 && !built; ++header.hashSeed) {
+        for (size_t k = 0; k < n; ++k) {
+            keys[k] = positionKey(graph.positions[k], header.hashSeed);
+        }
+        vector<uint64_t> sorted = keys;
+        sort(sorted.begin(), sorted.end());
+        if (adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) continue;  // коллизия 64-битных хешей позиций
+
+        built = buildPerfectHash(keys, header.bucketCount, header.slotCount, pilots, slotOfKey);
+        if (built) break;
+    }
+    if (!built) {
+        cerr << "Не удалось построить совершенную хеш-функцию\n";
+        return 1;
+    }
+
+    vector<uint64_t> slotKeys(header.slotCount, 0);
+    vector<uint64_t> used((header.slotCount + 63) / 64, 0);
+    vector<uint64_t> results((header.slotCount + 63) / 64, 0);
+    for (size_t k = 0; k < n; ++k) {
+        uint64_t slot = slotOfKey[k];
+        slotKeys[slot] = keys[k];
+        used[slot / 64] |= 1ULL << (slot % 64);
+        if (wins[k]) results[slot / 64] |= 1ULL << (slot % 64);
+    }
+
+    ofstream out(path, ios::binary);
+    if (!out.is_open()) {
+        cerr << "Не удалось открыть " << path << " для записи\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writePadded(out, pilots);
+    writePadded(out, slotKeys);
+    writePadded(out, used);
+    writePadded(out, results);
+    return out ? 0 : 1;
+}
+
+// Проходит новые случайные партии до конца и для каждой позиции в пределах бюджета сравнивает
+// ответ таблицы с решателем без таблицы; возвращает число расхождений
+size_t checkFreshGames(const EndgameTablebase& tablebase, int numGames, int budget, mt19937& rng) {
+    EndgameSolver solver(budget);
+    long long positions = 0, hits = 0, mismatches = 0;
+    double solveMicros = 0;
+
+    for (int game = 0; game < numGames; ++game) {
+        TablebasePosition p = dealPosition(rng);
+        while (true) {
+            if (p.handCards() <= budget) {
+                ++positions;
+                TablebaseResult stored = tablebase.probe(p);
+                auto start = chrono::steady_clock::now();
+                TablebaseResult solved = solver.solve(p);
+                solveMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+                if (stored != Unknown) {
+                    ++hits;
+                    if (stored != solved) ++mismatches;
+                }
+            }
+            auto next = tablebaseSuccessors(p);
+            if (next.empty()) break;
+            uniform_int_distribution<int> dist(0, (int)next.size() - 1);
+            p = next[dist(rng)];
+        }
+    }
+
+    cout << "Новые партии: позиций в пределах бюджета " << positions << ", попаданий в таблицу " << hits
+         << " (" << (positions ? 100.0 * hits / positions : 0.0) << "%)\n";
+    cout << "EndgameSolver: " << (positions ? solveMicros / positions : 0.0) << " мкс на позицию, решено перебором "
+         << solver.solved().size() << " позиций, расхождений с таблицей " << mismatches << "\n";
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Использование: " << argv[0] << " <tablebase.r7tb> [--budget N] [--games N] [--roots-from games.r7rp] [--seed S] [--check-games N] [--score-cache scores.r7sc]\n";
+        return 1;
+    }
+
+    string path = argv[1];
+    int budget = 6;
+    int numGames = 10000;
+    int checkGames = 1000;
+    unsigned int seed = random_device{}();
+    string scoreCachePath, rootsPath;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--budget") budget = stoi(argv[i + 1]);
+        else if (arg == "--games") numGames = stoi(argv[i + 1]);
+        else if (arg == "--check-games") checkGames = stoi(argv[i + 1]);
+        else if (arg == "--seed") seed = stoul(argv[i + 1]);
+        else if (arg == "--score-cache") scoreCachePath = argv[i + 1];
+        else if (arg == "--roots-from") rootsPath = argv[i + 1];
+        else {
+            cerr << "Неизвестный аргумент " << arg << "\n";
+            return 1;
+        }
+    }
+
+    unique_ptr<RuleScoreCache> scoreCache;
+    unique_ptr<ReplayReader> rootsReader;
+    try {
+        if (!scoreCachePath.empty()) {
+            scoreCache = make_unique<RuleScoreCache>(scoreCachePath);
+            scoreCache->install();
+        }
+        if (!rootsPath.empty()) {
+            rootsReader = make_unique<ReplayReader>(rootsPath);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    mt19937 rng(seed);
+
+    auto roots = rootsReader ? collectReplayRoots(*rootsReader, budget) : collectRoots(numGames, budget, rng);
+    cout << "Корневых позиций: " << roots.size() << "\n";
+
+    PositionGraph graph = enumeratePositions(roots);
+    cout << "Всего позиций: " << graph.positions.size() << ", ходов: " << graph.successors.size() << "\n";
+
+    vector<bool> wins = solvePositions(graph);
+    long long winCount = count(wins.begin(), wins.end(), true);
+    cout << "Выигрышных для ходящего: " << winCount << ", проигрышных: " << (long long)wins.size() - winCount << "\n";
+
+    if (writeTablebase(path, graph, wins, budget) != 0) {
+        return 1;
+    }
+
+    EndgameTablebase tablebase(path);
+    size_t mismatches = 0;
+    for (size_t k = 0; k < graph.positions.size(); ++k) {
+        TablebaseResult expected = wins[k] ? Win : Loss;
+        if (tablebase.probe(graph.positions[k]) != expected) ++mismatches;
+    }
+    cout << "Проверка таблицы: " << (mismatches == 0 ? "все позиции совпадают" : to_string(mismatches) + " несовпадений") << "\n";
+
+    // решатель без таблицы должен совпадать с ретроградным решением на выборке позиций таблицы
+    EndgameSolver reference(budget);
+    size_t solverMismatches = 0, step = max<size_t>(1, graph.positions.size() / 10000);
+    for (size_t k = 0; k < graph.positions.size(); k += step) {
+        if (reference.solve(graph.positions[k]) != (wins[k] ? Win : Loss)) ++solverMismatches;
+    }
+    cout << "Проверка EndgameSolver по таблице: " << (solverMismatches == 0 ? "все позиции совпадают" : to_string(solverMismatches) + " несовпадений") << "\n";
+    mismatches += solverMismatches + checkFreshGames(tablebase, checkGames, budget, rng);
+    if (rootsReader) {
+        mismatches += checkReplayGames(tablebase, *rootsReader, budget);
+    }
+    cout << "Время: " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " с\n";
+    return mismatches == 0 ? 0 : 1;
+}